@@ -103,6 +103,12 @@ Level = {
         scale = 2
     },
 
+    ----------------------------------------------------
+    -- collision broadphase: "grid" (default), "tree" or "sweep_and_prune"
+    -- (press B in game to record and compare them on this level)
+    ----------------------------------------------------
+    broadphase = "grid",
+
     ----------------------------------------------------
     -- table to define entities and their components
     ----------------------------------------------------
@@ -136,7 +142,9 @@ Level = {
                 boxcollider = {
                     width = 32,
                     height = 25,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "player",
+                    collides_with = { "enemy_projectiles" }
                 },
                 health = {
                     health_percentage = 100
@@ -184,7 +192,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 0, y = 7 }
+                    offset = { x = 0, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -223,7 +233,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 0, y = 7 }
+                    offset = { x = 0, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -262,7 +274,10 @@ Level = {
                 boxcollider = {
                     width = 16,
                     height = 32,
-                    offset = { x = 0, y = 7 }
+                    offset = { x = 0, y = 7 },
+                    layer = "obstacles",
+                    collides_with = { "enemies" },
+                    static = true
                 }
             }
         },
@@ -287,7 +302,10 @@ Level = {
                 boxcollider = {
                     width = 16,
                     height = 32,
-                    offset = { x = 0, y = 7 }
+                    offset = { x = 0, y = 7 },
+                    layer = "obstacles",
+                    collides_with = { "enemies" },
+                    static = true
                 }
             }
         },
@@ -396,7 +414,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 0, y = 7 }
+                    offset = { x = 0, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -432,7 +452,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 18,
-                    offset = { x = 7, y = 10 }
+                    offset = { x = 7, y = 10 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -468,7 +490,9 @@ Level = {
                 boxcollider = {
                     width = 20,
                     height = 18,
-                    offset = { x = 5, y = 7 }
+                    offset = { x = 5, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -504,7 +528,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 5, y = 7 }
+                    offset = { x = 5, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -540,7 +566,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 5, y = 7 }
+                    offset = { x = 5, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -576,7 +604,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 5, y = 7 }
+                    offset = { x = 5, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -612,7 +642,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 5, y = 7 }
+                    offset = { x = 5, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -648,7 +680,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 18,
-                    offset = { x = 8, y = 6 }
+                    offset = { x = 8, y = 6 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -684,7 +718,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 18,
-                    offset = { x = 8, y = 6 }
+                    offset = { x = 8, y = 6 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -741,7 +777,9 @@ Level = {
                 boxcollider = {
                     width = 20,
                     height = 17,
-                    offset = { x = 7, y = 7 }
+                    offset = { x = 7, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -777,7 +815,9 @@ Level = {
                 boxcollider = {
                     width = 18,
                     height = 20,
-                    offset = { x = 7, y = 7 }
+                    offset = { x = 7, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -813,7 +853,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 7, y = 7 }
+                    offset = { x = 7, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -849,7 +891,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 0, y = 7 }
+                    offset = { x = 0, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -885,7 +929,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 20,
-                    offset = { x = 8, y = 4 }
+                    offset = { x = 8, y = 4 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -921,7 +967,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 20,
-                    offset = { x = 7, y = 8 }
+                    offset = { x = 7, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -957,7 +1005,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 20,
-                    offset = { x = 7, y = 8 }
+                    offset = { x = 7, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -993,7 +1043,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 20,
-                    offset = { x = 7, y = 8 }
+                    offset = { x = 7, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1029,7 +1081,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 20,
-                    offset = { x = 7, y = 8 }
+                    offset = { x = 7, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1065,7 +1119,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 20,
-                    offset = { x = 7, y = 8 }
+                    offset = { x = 7, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1101,7 +1157,9 @@ Level = {
                 boxcollider = {
                     width = 22,
                     height = 18,
-                    offset = { x = 5, y = 7 }
+                    offset = { x = 5, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1137,7 +1195,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 18,
-                    offset = { x = 7, y = 7 }
+                    offset = { x = 7, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1173,7 +1233,9 @@ Level = {
                 boxcollider = {
                     width = 19,
                     height = 20,
-                    offset = { x = 6, y = 7 }
+                    offset = { x = 6, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1209,7 +1271,9 @@ Level = {
                 boxcollider = {
                     width = 18,
                     height = 25,
-                    offset = { x = 7, y = 7 }
+                    offset = { x = 7, y = 7 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1245,7 +1309,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 20,
-                    offset = { x = 8, y = 4 }
+                    offset = { x = 8, y = 4 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1302,7 +1368,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 25,
-                    offset = { x = 10, y = 2 }
+                    offset = { x = 10, y = 2 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1331,7 +1399,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 25,
-                    offset = { x = 10, y = 2 }
+                    offset = { x = 10, y = 2 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1360,7 +1430,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 25,
-                    offset = { x = 10, y = 2 }
+                    offset = { x = 10, y = 2 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1389,7 +1461,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 25,
-                    offset = { x = 10, y = 2 }
+                    offset = { x = 10, y = 2 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1418,7 +1492,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 25,
-                    offset = { x = 10, y = 2 }
+                    offset = { x = 10, y = 2 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1447,7 +1523,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 25,
-                    offset = { x = 10, y = 2 }
+                    offset = { x = 10, y = 2 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1476,7 +1554,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 20,
-                    offset = { x = 10, y = 8 }
+                    offset = { x = 10, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1505,7 +1585,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 20,
-                    offset = { x = 10, y = 8 }
+                    offset = { x = 10, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1534,7 +1616,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 20,
-                    offset = { x = 10, y = 8 }
+                    offset = { x = 10, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1563,7 +1647,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 16,
-                    offset = { x = 3, y = 10 }
+                    offset = { x = 3, y = 10 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1592,7 +1678,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 16,
-                    offset = { x = 3, y = 10 }
+                    offset = { x = 3, y = 10 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1625,7 +1713,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1665,7 +1755,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1705,7 +1797,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1745,7 +1839,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1781,7 +1877,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1817,7 +1915,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1853,7 +1953,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1889,7 +1991,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1925,7 +2029,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1961,7 +2067,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2913,7 +3021,9 @@ Level = {
                 boxcollider = {
                     width = 20,
                     height = 25,
-                    offset = { x = 5, y = 5}
+                    offset = { x = 5, y = 5},
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2949,7 +3059,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2982,7 +3094,9 @@ Level = {
                 boxcollider = {
                     width = 32,
                     height = 32,
-                    offset = { x = 0, y = 0 }
+                    offset = { x = 0, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -3018,7 +3132,9 @@ Level = {
                 boxcollider = {
                     width = 32,
                     height = 30,
-                    offset = { x = 0, y = 0 }
+                    offset = { x = 0, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -3129,7 +3245,9 @@ Level = {
                 },
                 boxcollider = {
                     width = 32,
-                    height = 32
+                    height = 32,
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -3195,7 +3313,9 @@ Level = {
                 },
                 boxcollider = {
                     width = 32,
-                    height = 32
+                    height = 32,
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
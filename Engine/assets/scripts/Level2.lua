@@ -90,6 +90,12 @@ Level = {
         scale = 2.0
     },
 
+    ----------------------------------------------------
+    -- collision broadphase: "grid" (default), "tree" or "sweep_and_prune"
+    -- (press B in game to record and compare them on this level)
+    ----------------------------------------------------
+    broadphase = "grid",
+
     ----------------------------------------------------
     -- table to define entities and their components
     ----------------------------------------------------
@@ -119,7 +125,9 @@ Level = {
                 boxcollider = {
                     width = 32,
                     height = 25,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "player",
+                    collides_with = { "enemy_projectiles" }
                 },
                 health = {
                     health_percentage = 100
@@ -346,7 +354,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -382,7 +392,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -418,7 +430,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -454,7 +468,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -490,7 +506,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -526,7 +544,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -562,7 +582,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -599,7 +621,9 @@ Level = {
                 boxcollider = {
                     width = 17,
                     height = 15,
-                    offset = { x = 8, y = 8 }
+                    offset = { x = 8, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -631,7 +655,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -663,7 +689,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -695,7 +723,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -727,7 +757,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -759,7 +791,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -791,7 +825,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -823,7 +859,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -855,7 +893,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -887,7 +927,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -919,7 +961,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 20,
-                    offset = { x = 10, y = 8 }
+                    offset = { x = 10, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -951,7 +995,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 20,
-                    offset = { x = 10, y = 8 }
+                    offset = { x = 10, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -983,7 +1029,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 20,
-                    offset = { x = 10, y = 8 }
+                    offset = { x = 10, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1015,7 +1063,9 @@ Level = {
                 boxcollider = {
                     width = 12,
                     height = 20,
-                    offset = { x = 10, y = 8 }
+                    offset = { x = 10, y = 8 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1047,7 +1097,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1079,7 +1131,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -1111,7 +1165,9 @@ Level = {
                 boxcollider = {
                     width = 30,
                     height = 20,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2235,7 +2291,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2267,7 +2325,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2299,7 +2359,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2331,7 +2393,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2363,7 +2427,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2392,7 +2458,9 @@ Level = {
                 boxcollider = {
                     width = 20,
                     height = 25,
-                    offset = { x = 5, y = 5}
+                    offset = { x = 5, y = 5},
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2421,7 +2489,9 @@ Level = {
                 boxcollider = {
                     width = 32,
                     height = 32,
-                    offset = { x = 0, y = 0 }
+                    offset = { x = 0, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2453,7 +2523,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2485,7 +2557,9 @@ Level = {
                 boxcollider = {
                     width = 25,
                     height = 30,
-                    offset = { x = 5, y = 0 }
+                    offset = { x = 5, y = 0 },
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2516,7 +2590,9 @@ Level = {
                 },
                 boxcollider = {
                     width = 32,
-                    height = 32
+                    height = 32,
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
@@ -2569,7 +2645,9 @@ Level = {
                 },
                 boxcollider = {
                     width = 32,
-                    height = 24
+                    height = 24,
+                    layer = "enemies",
+                    collides_with = { "friendly_projectiles", "obstacles" }
                 },
                 health = {
                     health_percentage = 100
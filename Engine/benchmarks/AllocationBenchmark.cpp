@@ -0,0 +1,164 @@
+// Count the heap allocations of spawning 10000 projectiles, once the storage has grown to fit them.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../src/ECS/ECS.h"
+#include "Benchmark.h"
+
+static std::atomic<long> num_allocations(0);
+
+void* operator new(size_t size) {
+    num_allocations++;
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+struct Position
+{
+    float x;
+    float y;
+    Position(float x = 0.0f, float y = 0.0f) : x(x), y(y) {}
+};
+
+struct Velocity
+{
+    float x;
+    float y;
+    Velocity(float x = 0.0f, float y = 0.0f) : x(x), y(y) {}
+};
+
+// A component owning a string too long for the small string buffer, like a sprite or label
+// with a long asset id. Short ids such as "bullet-texture" do not allocate at all.
+struct Label
+{
+    std::string text;
+    Label(std::string text = "") : text(std::move(text)) {}
+};
+
+const int NUM_PROJECTILES = 10000;
+const char* const LABEL_TEXT = "enemy-projectile-texture";
+
+// Allocations made by func.
+template <typename TFunc>
+long CountAllocations(TFunc&& func) {
+    const long before = num_allocations;
+    func();
+    return num_allocations - before;
+}
+
+// What AddComponent did before in-place construction: build a temporary, copy it into the by-value parameter
+// of Pool::Set(), then copy that into the pool.
+template <typename T, typename ...TArgs>
+void AddByCopy(Pool<T>& pool, int entity_id, TArgs&& ...args) {
+    T new_component(std::forward<TArgs>(args)...);
+    T object = new_component;
+    pool.Emplace(entity_id, static_cast<const T&>(object));
+}
+
+// Fill the pools once so they have grown, empty them, and count the allocations of filling them again.
+template <typename TAdd>
+long CountPoolAllocations(TAdd&& add) {
+    Pool<Position> positions;
+    Pool<Velocity> velocities;
+    Pool<Label> labels;
+    long count = 0;
+    for (int frame = 0; frame < 2; frame++) {
+        count = CountAllocations([&]() {
+            for (int entity_id = 0; entity_id < NUM_PROJECTILES; entity_id++) {
+                add(positions, velocities, labels, entity_id);
+            }
+        });
+        for (int entity_id = 0; entity_id < NUM_PROJECTILES; entity_id++) {
+            positions.Remove(entity_id);
+            velocities.Remove(entity_id);
+            labels.Remove(entity_id);
+        }
+    }
+    return count;
+}
+
+// Spawn and kill the projectiles twice, and count the allocations of spawning them a third time.
+// The first respawn of a recyclable prefab is the first to reuse entities, so it still grows the registry.
+template <typename TSpawn>
+long CountRegistryAllocations(TSpawn&& spawn) {
+    Registry registry;
+    std::vector<Entity> projectiles;
+    projectiles.reserve(NUM_PROJECTILES);
+    long count = 0;
+    for (int frame = 0; frame < 3; frame++) {
+        projectiles.clear();
+        count = CountAllocations([&]() {
+            spawn(registry, projectiles);
+            registry.Update();
+        });
+        for (auto projectile : projectiles) {
+            projectile.Kill();
+        }
+        registry.Update();
+    }
+    return count;
+}
+
+int main() {
+    const long copied = CountPoolAllocations([](Pool<Position>& positions, Pool<Velocity>& velocities, Pool<Label>& labels, int entity_id) {
+        AddByCopy(positions, entity_id, 1.0f, 2.0f);
+        AddByCopy(velocities, entity_id, 0.0f, -100.0f);
+        AddByCopy(labels, entity_id, LABEL_TEXT);
+    });
+    const long emplaced = CountPoolAllocations([](Pool<Position>& positions, Pool<Velocity>& velocities, Pool<Label>& labels, int entity_id) {
+        positions.Emplace(entity_id, 1.0f, 2.0f);
+        velocities.Emplace(entity_id, 0.0f, -100.0f);
+        labels.Emplace(entity_id, LABEL_TEXT);
+    });
+
+    const long added = CountRegistryAllocations([](Registry& registry, std::vector<Entity>& projectiles) {
+        for (int i = 0; i < NUM_PROJECTILES; i++) {
+            Entity projectile = registry.CreateEntity();
+            projectile.AddComponent<Position>(1.0f, 2.0f);
+            projectile.AddComponent<Velocity>(0.0f, -100.0f);
+            projectile.AddComponent<Label>(LABEL_TEXT);
+            projectiles.push_back(projectile);
+        }
+    });
+    Prefab projectile_prefab;
+    projectile_prefab.AddComponent<Position>();
+    projectile_prefab.AddComponent<Velocity>(0.0f, -100.0f);
+    projectile_prefab.AddComponent<Label>(LABEL_TEXT);
+    const long spawned = CountRegistryAllocations([&projectile_prefab](Registry& registry, std::vector<Entity>& projectiles) {
+        registry.Spawn(projectile_prefab, NUM_PROJECTILES, [&projectiles](Entity projectile, int) {
+            projectile.GetComponent<Position>() = Position(1.0f, 2.0f);
+            projectiles.push_back(projectile);
+        });
+    });
+    Prefab recyclable_projectile_prefab = projectile_prefab;
+    recyclable_projectile_prefab.SetRecyclable(true);
+    const long recycled = CountRegistryAllocations([&recyclable_projectile_prefab](Registry& registry, std::vector<Entity>& projectiles) {
+        registry.Spawn(recyclable_projectile_prefab, NUM_PROJECTILES, [&projectiles](Entity projectile, int) {
+            projectile.GetComponent<Position>() = Position(1.0f, 2.0f);
+            projectiles.push_back(projectile);
+        });
+    });
+
+    std::printf("heap allocations to spawn %d projectiles (position, velocity, %zu-character label), once the storage has grown\n",
+        NUM_PROJECTILES, std::string(LABEL_TEXT).size());
+    std::printf("  %-40s %8ld  (%.2f per projectile)\n", "pools, temporary copied in", copied, double(copied) / NUM_PROJECTILES);
+    std::printf("  %-40s %8ld  (%.2f per projectile)\n", "pools, constructed in place", emplaced, double(emplaced) / NUM_PROJECTILES);
+    std::printf("  %-40s %8ld  (%.2f per projectile)\n", "registry, CreateEntity + AddComponent", added, double(added) / NUM_PROJECTILES);
+    std::printf("  %-40s %8ld  (%.2f per projectile)\n", "registry, Spawn", spawned, double(spawned) / NUM_PROJECTILES);
+    std::printf("  %-40s %8ld  (%.2f per projectile)\n", "registry, Spawn from a recyclable prefab", recycled, double(recycled) / NUM_PROJECTILES);
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Run func repetitions times and return the fastest run in milliseconds.
+template <typename TFunc>
+double MeasureMilliseconds(int repetitions, TFunc&& func) {
+    double best = 0.0;
+    for (int i = 0; i < repetitions; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const auto end = std::chrono::steady_clock::now();
+        const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        best = i == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+// Keeps the compiler from dropping the loops whose result is otherwise unused.
+template <typename T>
+void KeepResult(const T& value) {
+    static volatile T sink;
+    sink = value;
+    static_cast<void>(sink);
+}
+
+inline void PrintResult(const char* name, double milliseconds, double baseline_milliseconds) {
+    std::printf("  %-28s %9.3f ms  (%.2fx)\n", name, milliseconds, baseline_milliseconds / milliseconds);
+}
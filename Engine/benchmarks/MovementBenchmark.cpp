@@ -0,0 +1,131 @@
+// Move entities through a View in two ways: integrating every entity inside the view loop (as MovementSystem does),
+// and gathering batches of entities into float arrays for the SIMD motion kernel, then scattering the new positions back.
+// The motion kernel alone, on arrays that are already gathered, shows what the staging costs.
+
+#include <random>
+#include <vector>
+
+#include "../src/ECS/ECS.h"
+#include "../src/Physics/MotionKernel.h"
+#include "Benchmark.h"
+
+// Same layout as the transform and rigid body components.
+struct Transform
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    double rotation = 0.0;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+const int NUM_ENTITIES = 1000000;
+const int NUM_REPETITIONS = 10;
+const size_t BATCH_SIZE = 256;
+const float MAP_WIDTH = 3200.0f;
+const float MAP_HEIGHT = 1920.0f;
+const float DELTA_TIME = 1.0f / 60.0f;
+
+static bool IsOutOfMap(float x, float y) {
+    return x < 0 || x > MAP_WIDTH || y < 0 || y > MAP_HEIGHT;
+}
+
+struct MotionBatch
+{
+    size_t count = 0;
+    float position_x[BATCH_SIZE];
+    float position_y[BATCH_SIZE];
+    float velocity_x[BATCH_SIZE];
+    float velocity_y[BATCH_SIZE];
+    int out_of_map_indices[BATCH_SIZE];
+    Transform* transforms[BATCH_SIZE];
+    int entity_ids[BATCH_SIZE];
+    int entity_generations[BATCH_SIZE];
+};
+
+static void IntegrateBatch(MotionBatch& batch, std::vector<Entity>& out_of_map_entities) {
+    const MotionArrays motion = { batch.position_x, batch.position_y, batch.velocity_x, batch.velocity_y };
+    const size_t num_out_of_map = IntegrateMotion(motion, batch.count, DELTA_TIME, MAP_WIDTH, MAP_HEIGHT, batch.out_of_map_indices);
+    for (size_t i = 0; i < batch.count; i++) {
+        batch.transforms[i]->x = batch.position_x[i];
+        batch.transforms[i]->y = batch.position_y[i];
+    }
+    for (size_t i = 0; i < num_out_of_map; i++) {
+        const int index = batch.out_of_map_indices[i];
+        out_of_map_entities.emplace_back(batch.entity_ids[index], batch.entity_generations[index]);
+    }
+    batch.count = 0;
+}
+
+int main() {
+    Registry registry;
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> x(0.0f, MAP_WIDTH), y(0.0f, MAP_HEIGHT), velocity(-100.0f, 100.0f);
+    std::vector<float> position_x, position_y, velocity_x, velocity_y;
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<Transform>(Transform{x(random), y(random)});
+        entity.AddComponent<Velocity>(Velocity{velocity(random), velocity(random)});
+        position_x.push_back(entity.ReadComponent<Transform>().x);
+        position_y.push_back(entity.ReadComponent<Transform>().y);
+        velocity_x.push_back(entity.ReadComponent<Velocity>().x);
+        velocity_y.push_back(entity.ReadComponent<Velocity>().y);
+    }
+    registry.Update();
+
+    std::vector<Entity> out_of_map_entities;
+    out_of_map_entities.reserve(NUM_ENTITIES);
+    const double view_milliseconds = MeasureMilliseconds(NUM_REPETITIONS, [&]() {
+        out_of_map_entities.clear();
+        registry.View<Transform, Velocity>().Each([&](Entity entity, Transform& transform, const Velocity& velocity) {
+            transform.x += velocity.x * DELTA_TIME;
+            transform.y += velocity.y * DELTA_TIME;
+            if (IsOutOfMap(transform.x, transform.y)) {
+                out_of_map_entities.push_back(entity);
+            }
+        });
+        KeepResult(out_of_map_entities.size());
+    });
+
+    MotionBatch batch;
+    const double batch_milliseconds = MeasureMilliseconds(NUM_REPETITIONS, [&]() {
+        out_of_map_entities.clear();
+        registry.View<Transform, Velocity>().Each([&](Entity entity, Transform& transform, const Velocity& velocity) {
+            batch.position_x[batch.count] = transform.x;
+            batch.position_y[batch.count] = transform.y;
+            batch.velocity_x[batch.count] = velocity.x;
+            batch.velocity_y[batch.count] = velocity.y;
+            batch.transforms[batch.count] = &transform;
+            batch.entity_ids[batch.count] = entity.GetId();
+            batch.entity_generations[batch.count] = entity.GetGeneration();
+            if (++batch.count == BATCH_SIZE) {
+                IntegrateBatch(batch, out_of_map_entities);
+            }
+        });
+        IntegrateBatch(batch, out_of_map_entities);
+        KeepResult(out_of_map_entities.size());
+    });
+
+    std::vector<int> out_of_map_indices(NUM_ENTITIES);
+    const double kernel_milliseconds = MeasureMilliseconds(NUM_REPETITIONS, [&]() {
+        const MotionArrays motion = { position_x.data(), position_y.data(), velocity_x.data(), velocity_y.data() };
+        KeepResult(IntegrateMotion(motion, NUM_ENTITIES, DELTA_TIME, MAP_WIDTH, MAP_HEIGHT, out_of_map_indices.data()));
+    });
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    std::printf("archetype storage, ");
+#else
+    std::printf("pool storage, ");
+#endif
+    std::printf("%d moving entities, best of %d runs\n", NUM_ENTITIES, NUM_REPETITIONS);
+    PrintResult("view, integrate in the loop", view_milliseconds, view_milliseconds);
+    PrintResult("view, gather/kernel/scatter", batch_milliseconds, view_milliseconds);
+    PrintResult("kernel on gathered arrays", kernel_milliseconds, view_milliseconds);
+    return 0;
+}
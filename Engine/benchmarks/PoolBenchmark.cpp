@@ -0,0 +1,180 @@
+// Insert, lookup, iterate and remove components with Pool<T> and with the hash map pool it replaced.
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/ECS/ECS.h"
+#include "Benchmark.h"
+
+// The component pool as it was before the paged sparse set: a vector of components,
+// and two hash maps between entity ids and packed indices.
+template <typename T>
+class HashMapPool
+{
+private:
+    std::vector<T> data;
+    int size;
+    std::unordered_map<int, int> entity_id_to_index;
+    std::unordered_map<int, int> index_to_entity_id;
+
+public:
+    HashMapPool(int capacity = 100) {
+        size = 0;
+        data.resize(capacity);
+    }
+
+    int GetSize() const {
+        return size;
+    }
+
+    void Set(int entity_id, T object) {
+        if (entity_id_to_index.find(entity_id) != entity_id_to_index.end()) {
+            int index = entity_id_to_index[entity_id];
+            data[index] = object;
+        } else {
+            int index = size;
+            entity_id_to_index.emplace(entity_id, index);
+            index_to_entity_id.emplace(index, entity_id);
+            if (index >= static_cast<int>(data.capacity())) {
+                data.resize(size * 2);
+            }
+            data[index] = object;
+            size++;
+        }
+    }
+
+    void Remove(int entity_id) {
+        int index_of_removed = entity_id_to_index[entity_id];
+        int index_of_last = size - 1;
+        data[index_of_removed] = data[index_of_last];
+
+        int entity_id_of_last_element = index_to_entity_id[index_of_last];
+        entity_id_to_index[entity_id_of_last_element] = index_of_removed;
+        index_to_entity_id[index_of_removed] = entity_id_of_last_element;
+
+        entity_id_to_index.erase(entity_id);
+        index_to_entity_id.erase(index_of_last);
+
+        size--;
+    }
+
+    T& Get(int entity_id) {
+        int index = entity_id_to_index[entity_id];
+        return data[index];
+    }
+
+    T& operator [](unsigned int index) {
+        return data[index];
+    }
+
+    template <typename TFunc>
+    void Each(TFunc&& func) {
+        for (int i = 0; i < size; i++) {
+            func(data[i]);
+        }
+    }
+};
+
+// Same size as the transform component.
+struct Position
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    double rotation = 0.0;
+};
+
+const int NUM_ENTITIES[] = {10000, 100000, 1000000};
+
+struct PoolTimes
+{
+    double insert = 0.0;
+    double lookup = 0.0;
+    double iterate = 0.0;
+    double remove = 0.0;
+};
+
+// insert: add a component to every entity of a fresh pool.
+// lookup: get the component of every entity by id, in the order systems keep their entities.
+// iterate: walk the packed components with Each().
+// remove: remove the components of half the entities, in random order.
+template <typename TPool>
+PoolTimes MeasurePool(const std::vector<int>& entity_ids, const std::vector<int>& removed_entity_ids) {
+    // Fewer runs for the large pools, which take long to fill.
+    const int num_repetitions = entity_ids.size() > 100000 ? 3 : 10;
+    PoolTimes times;
+    times.insert = MeasureMilliseconds(num_repetitions, [&]() {
+        TPool pool;
+        for (int entity_id : entity_ids) {
+            pool.Set(entity_id, Position());
+        }
+        KeepResult(pool.GetSize());
+    });
+
+    TPool pool;
+    for (int entity_id : entity_ids) {
+        pool.Set(entity_id, Position{static_cast<float>(entity_id)});
+    }
+    times.lookup = MeasureMilliseconds(num_repetitions, [&]() {
+        float sum = 0.0f;
+        for (int entity_id : entity_ids) {
+            sum += pool.Get(entity_id).x;
+        }
+        KeepResult(sum);
+    });
+    times.iterate = MeasureMilliseconds(num_repetitions, [&]() {
+        float sum = 0.0f;
+        pool.Each([&sum](const Position& position) {
+            sum += position.x;
+        });
+        KeepResult(sum);
+    });
+
+    // Removal empties the pool, so each run starts from a filled copy that is not timed.
+    times.remove = 0.0;
+    for (int repetition = 0; repetition < num_repetitions; repetition++) {
+        TPool filled_pool;
+        for (int entity_id : entity_ids) {
+            filled_pool.Set(entity_id, Position());
+        }
+        const double milliseconds = MeasureMilliseconds(1, [&]() {
+            for (int entity_id : removed_entity_ids) {
+                filled_pool.Remove(entity_id);
+            }
+            KeepResult(filled_pool.GetSize());
+        });
+        times.remove = repetition == 0 ? milliseconds : std::min(times.remove, milliseconds);
+    }
+    return times;
+}
+
+int main() {
+    std::printf("best of 10 runs (3 for 1000000 entities), speedup over the hash map pool in parentheses\n");
+    for (int num_entities : NUM_ENTITIES) {
+        std::vector<int> entity_ids(num_entities);
+        std::iota(entity_ids.begin(), entity_ids.end(), 0);
+        std::vector<int> removed_entity_ids = entity_ids;
+        std::shuffle(removed_entity_ids.begin(), removed_entity_ids.end(), std::mt19937(42));
+        removed_entity_ids.resize(num_entities / 2);
+
+        const PoolTimes old_times = MeasurePool<HashMapPool<Position>>(entity_ids, removed_entity_ids);
+        const PoolTimes new_times = MeasurePool<Pool<Position>>(entity_ids, removed_entity_ids);
+
+        std::printf("%d entities\n", num_entities);
+        std::printf(" hash map pool:\n");
+        PrintResult("insert", old_times.insert, old_times.insert);
+        PrintResult("lookup by entity id", old_times.lookup, old_times.lookup);
+        PrintResult("iterate packed", old_times.iterate, old_times.iterate);
+        PrintResult("remove half", old_times.remove, old_times.remove);
+        std::printf(" sparse set pool:\n");
+        PrintResult("insert", new_times.insert, old_times.insert);
+        PrintResult("lookup by entity id", new_times.lookup, old_times.lookup);
+        PrintResult("iterate packed", new_times.iterate, old_times.iterate);
+        PrintResult("remove half", new_times.remove, old_times.remove);
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Move entities through a system's entity list and per-entity component lookups, as the systems did
+// before views, and through a View over the packed components.
+
+#include "../src/ECS/ECS.h"
+#include "Benchmark.h"
+
+struct Position
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Velocity
+{
+    float x = 1.0f;
+    float y = 1.0f;
+};
+
+class MoveSystem : public System
+{
+public:
+    MoveSystem() {
+        RequireComponent<Position>();
+        RequireComponent<Velocity>();
+    }
+};
+
+const int NUM_ENTITIES = 100000;
+const int NUM_REPETITIONS = 20;
+
+int main() {
+    Registry registry;
+    registry.AddSystem<MoveSystem>();
+    // One entity in four has no velocity, so the view has entities to skip.
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<Position>();
+        if (i % 4 != 0) {
+            entity.AddComponent<Velocity>();
+        }
+    }
+    registry.Update();
+
+    const double lookup_milliseconds = MeasureMilliseconds(NUM_REPETITIONS, [&]() {
+        for (auto entity : registry.GetSystem<MoveSystem>().GetSystemEntities()) {
+            auto& position = entity.GetComponent<Position>();
+            const auto& velocity = entity.GetComponent<Velocity>();
+            position.x += velocity.x;
+            position.y += velocity.y;
+        }
+    });
+    const double view_milliseconds = MeasureMilliseconds(NUM_REPETITIONS, [&]() {
+        registry.View<Position, Velocity>().Each([](Entity, Position& position, const Velocity& velocity) {
+            position.x += velocity.x;
+            position.y += velocity.y;
+        });
+    });
+    const double read_lookup_milliseconds = MeasureMilliseconds(NUM_REPETITIONS, [&]() {
+        float sum = 0.0f;
+        for (auto entity : registry.GetSystem<MoveSystem>().GetSystemEntities()) {
+            sum += registry.ReadComponent<Position>(entity).x + registry.ReadComponent<Velocity>(entity).x;
+        }
+        KeepResult(sum);
+    });
+    const double read_view_milliseconds = MeasureMilliseconds(NUM_REPETITIONS, [&]() {
+        float sum = 0.0f;
+        registry.View<Position, Velocity>().Each([&sum](Entity, const Position& position, const Velocity& velocity) {
+            sum += position.x + velocity.x;
+        });
+        KeepResult(sum);
+    });
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    std::printf("archetype storage, ");
+#else
+    std::printf("pool storage, ");
+#endif
+    std::printf("%d entities, %d with both components, best of %d runs\n", NUM_ENTITIES, NUM_ENTITIES * 3 / 4, NUM_REPETITIONS);
+    std::printf("update position from velocity:\n");
+    PrintResult("system entities + lookups", lookup_milliseconds, lookup_milliseconds);
+    PrintResult("view", view_milliseconds, lookup_milliseconds);
+    std::printf("read both components:\n");
+    PrintResult("system entities + lookups", read_lookup_milliseconds, read_lookup_milliseconds);
+    PrintResult("view", read_view_milliseconds, read_lookup_milliseconds);
+    return 0;
+}
@@ -2,6 +2,8 @@
 
 #include <SDL2/SDL.h>
 
+#include "../ECS/ComponentId.h"
+
 struct AnimationComponent
 {
     int num_frames;
@@ -17,4 +19,6 @@ struct AnimationComponent
         this->is_loop = is_loop;
         this->start_time = SDL_GetTicks();
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(AnimationComponent, 3);
\ No newline at end of file
@@ -2,15 +2,29 @@
 
 #include <glm/glm.hpp>
 
+#include "../ECS/ComponentId.h"
+#include "../Physics/CollisionLayers.h"
+
 struct BoxColliderComponent
 {
     int width;
     int height;
     glm::vec2 offset;
+    // Collision layer bit of the collider, and the layers it collides with (see GetCollisionLayer()).
+    uint32_t layer;
+    uint32_t collision_mask;
+    // The collider never moves, even though its entity has a rigid body.
+    // Colliders of entities without a rigid body are always considered static.
+    bool is_static;
 
-    BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0, 0)) {
+    BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0, 0), uint32_t layer = DEFAULT_COLLISION_LAYER, uint32_t collision_mask = ALL_COLLISION_LAYERS, bool is_static = false) {
         this->width = width;
         this->height = height;
         this->offset = offset;
+        this->layer = layer;
+        this->collision_mask = collision_mask;
+        this->is_static = is_static;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(BoxColliderComponent, 4);
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "../ECS/ComponentId.h"
+
 struct CameraFollowComponent
 {
     CameraFollowComponent() = default;
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(CameraFollowComponent, 6);
\ No newline at end of file
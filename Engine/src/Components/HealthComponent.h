@@ -1,9 +1,13 @@
 #pragma once
 
+#include "../ECS/ComponentId.h"
+
 struct HealthComponent
 {
     int health_percentage;
     HealthComponent(int health_percentage = 0) {
         this->health_percentage = health_percentage;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(HealthComponent, 9);
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
 
+#include "../ECS/ComponentId.h"
+
 struct HealthLabelComponent
 {
     glm::vec2 position;
@@ -14,7 +16,9 @@ struct HealthLabelComponent
     HealthLabelComponent(std::string asset_id = "", const SDL_Color& color = {0, 0, 0}) {
         this->position = glm::vec2(0);
         this->text = "";
-        this->asset_id = asset_id;
+        this->asset_id = std::move(asset_id);
         this->color = color;
     }
 };
+
+REGISTER_COMPONENT(HealthLabelComponent, 10);
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include "../ECS/ComponentId.h"
+
 struct KeyboardControlledComponent
 {
     glm::vec2 up_velocity;
@@ -20,4 +22,6 @@ struct KeyboardControlledComponent
         this->down_velocity = down_velocity;
         this->left_velocity = left_velocity;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(KeyboardControlledComponent, 5);
\ No newline at end of file
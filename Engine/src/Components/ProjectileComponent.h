@@ -2,6 +2,8 @@
 
 #include <SDL2/SDL.h>
 
+#include "../ECS/ComponentId.h"
+
 struct ProjectileComponent
 {
     bool is_friendly;
@@ -15,4 +17,6 @@ struct ProjectileComponent
         this->duration = duration;
         this->start_time = SDL_GetTicks();
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(ProjectileComponent, 8);
\ No newline at end of file
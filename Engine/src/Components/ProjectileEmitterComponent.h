@@ -3,6 +3,8 @@
 #include <glm\glm.hpp>
 #include <SDL2/SDL.h>
 
+#include "../ECS/ComponentId.h"
+
 struct ProjectileEmitterComponent
 {
     glm::vec2 projectile_velocity;
@@ -26,4 +28,6 @@ struct ProjectileEmitterComponent
         this->is_friendly = is_friendly;
         this->last_emission_time = SDL_GetTicks();
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(ProjectileEmitterComponent, 7);
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include "../ECS/ComponentId.h"
+
 
 struct RigidBodyComponent
 {
@@ -10,4 +12,6 @@ struct RigidBodyComponent
     RigidBodyComponent(glm::vec2 velocity = glm::vec2(0.0, 0.0)) {
         this->velocity = velocity;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(RigidBodyComponent, 1);
\ No newline at end of file
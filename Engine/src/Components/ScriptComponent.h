@@ -2,10 +2,14 @@
 
 #include <sol/sol.hpp>
 
+#include "../ECS/ComponentId.h"
+
 struct ScriptComponent
 {
     sol::function func;
     ScriptComponent(sol::function func = sol::lua_nil) {
-        this->func = func;
+        this->func = std::move(func);
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(ScriptComponent, 12);
\ No newline at end of file
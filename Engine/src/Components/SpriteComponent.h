@@ -3,6 +3,8 @@
 #include <string>
 #include <SDL2/SDL.h>
 
+#include "../ECS/ComponentId.h"
+
 struct SpriteComponent
 {
     std::string asset_id;
@@ -22,7 +24,7 @@ struct SpriteComponent
         int src_rect_x = 0,
         int src_rect_y = 0
     ) {
-        this->asset_id = asset_id;
+        this->asset_id = std::move(asset_id);
         this->width = width;
         this->height = height;
         this->zindex = zindex;
@@ -30,4 +32,6 @@ struct SpriteComponent
         this->is_fixed = is_fixed;
         this->src_rect = {src_rect_x, src_rect_y, width, height};
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(SpriteComponent, 2);
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
 
+#include "../ECS/ComponentId.h"
+
 struct TextLabelComponent
 {
     glm::vec2 position;
@@ -20,9 +22,11 @@ struct TextLabelComponent
         bool is_fixed = true
     ) {
         this->position = position;
-        this->text = text;
-        this->asset_id = asset_id;
+        this->text = std::move(text);
+        this->asset_id = std::move(asset_id);
         this->color = color;
         this->is_fixed = is_fixed;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(TextLabelComponent, 11);
\ No newline at end of file
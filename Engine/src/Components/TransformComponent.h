@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include "../ECS/ComponentId.h"
+
 // components are nothing but plain old data.
 
 struct TransformComponent
@@ -15,4 +17,6 @@ struct TransformComponent
         this->scale = scale;
         this->rotation = rotation;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_COMPONENT(TransformComponent, 0);
\ No newline at end of file
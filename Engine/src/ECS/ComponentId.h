@@ -0,0 +1,26 @@
+#pragma once
+
+// Maximum number of component types.
+const unsigned int MAX_COMPONENTS = 256;
+
+// Ids below this value are reserved for the components registered with REGISTER_COMPONENT.
+// Unregistered components get the remaining ids, in the order they are first used.
+const unsigned int MAX_REGISTERED_COMPONENTS = 128;
+
+// Compile-time id of the component type T (-1 when T was not registered).
+template <typename T>
+struct ComponentId
+{
+    static constexpr int value = -1;
+};
+
+// Gives a component type a fixed id, so that signatures do not depend on the order in which
+// components are first used. Use it at global scope, right after the component definition:
+// REGISTER_COMPONENT(TransformComponent, 0);
+#define REGISTER_COMPONENT(TComponent, ID) \
+    template <> \
+    struct ComponentId<TComponent> \
+    { \
+        static_assert((ID) >= 0 && (ID) < static_cast<int>(MAX_REGISTERED_COMPONENTS), "Registered component ids must be below MAX_REGISTERED_COMPONENTS"); \
+        static constexpr int value = (ID); \
+    }
@@ -1,47 +1,442 @@
 #include "ECS.h"
 #include "../Logger/Logger.h"
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_set>
 
-int IComponent::next_id = 0;
+int IComponent::next_id = MAX_REGISTERED_COMPONENTS;
+
+int IComponent::GetNextId() {
+    if (next_id >= static_cast<int>(MAX_COMPONENTS)) {
+        Logger::Err("Too many component types, at most " + std::to_string(MAX_COMPONENTS - MAX_REGISTERED_COMPONENTS) + " can be unregistered.");
+        std::abort();
+    }
+    return next_id++;
+}
 
 int Entity::GetId() const { return id; }
 
+int Entity::GetGeneration() const { return generation; }
+
+bool Entity::IsAlive() const {
+    return registry->IsAlive(*this);
+}
+
 void Entity::Tag(const std::string& tag) {
     registry->TagEntity(*this, tag);
 }
 
+void Entity::Tag(TagId tag) {
+    registry->TagEntity(*this, tag);
+}
+
 bool Entity::HasTag(const std::string& tag) const {
     return registry->EntityHasTag(*this, tag);
 }
 
+bool Entity::HasTag(TagId tag) const {
+    return registry->EntityHasTag(*this, tag);
+}
+
 void Entity::Group(const std::string& group) {
     registry->GroupEntity(*this, group);
 }
 
+void Entity::Group(GroupId group) {
+    registry->GroupEntity(*this, group);
+}
+
 bool Entity::BelongsToGroup(const std::string& group) const {
     return registry->EntityBelongsToGroup(*this, group);
 }
 
+bool Entity::BelongsToGroup(GroupId group) const {
+    return registry->EntityBelongsToGroup(*this, group);
+}
+
+/*
+* Name Table
+*/
+int NameTable::Intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ids_per_name.emplace(name, static_cast<int>(ids_per_name.size())).first->second;
+}
+
+int NameTable::Find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto id = ids_per_name.find(name);
+    return id != ids_per_name.end() ? id->second : -1;
+}
+
 void Entity::Kill() {
     registry->KillEntity(*this);
 }
 
+void System::SwapEntities(int index_a, int index_b) {
+    std::swap(entities[index_a], entities[index_b]);
+    entity_indices[entities[index_a].GetId()] = index_a;
+    entity_indices[entities[index_b].GetId()] = index_b;
+}
+
 void System::AddEntityToSystem(Entity entity) {
+    const auto entity_id = entity.GetId();
+    if (static_cast<size_t>(entity_id) >= entity_indices.size()) {
+        entity_indices.resize(entity_id + 1, -1);
+    }
+    if (entity_indices[entity_id] != -1) {
+        return;
+    }
+    entity_indices[entity_id] = static_cast<int>(entities.size());
     entities.push_back(entity);
+
+    // Move the new member in front of the disabled ones.
+    SwapEntities(static_cast<int>(num_enabled_entities), entity_indices[entity_id]);
+    num_enabled_entities++;
+
+    if (is_tracking_new_entities) {
+        new_entities.push_back(entity);
+    }
 }
 
 void System::RemoveEntityFromSystem(Entity entity) {
-    entities.erase(std::remove_if(entities.begin(), entities.end(),
-                                  [&entity](Entity other) { return entity == other; }), entities.end());
+    if (!HasEntity(entity)) {
+        return;
+    }
+    const auto entity_id = entity.GetId();
+    // Move the member to the disabled part first, so the enabled part stays packed too.
+    DisableEntityInSystem(entity);
+
+    // Move the last member into the removed slot to keep the vector packed.
+    SwapEntities(entity_indices[entity_id], static_cast<int>(entities.size()) - 1);
+    entity_indices[entity_id] = -1;
+    entities.pop_back();
 }
 
-std::vector<Entity> System::GetSystemEntities() const {
-    return entities;
+void System::DisableEntityInSystem(Entity entity) {
+    const int index = entity_indices[entity.GetId()];
+    if (static_cast<size_t>(index) < num_enabled_entities) {
+        num_enabled_entities--;
+        SwapEntities(index, static_cast<int>(num_enabled_entities));
+    }
+}
+
+void System::EnableEntityInSystem(Entity entity) {
+    const int index = entity_indices[entity.GetId()];
+    if (static_cast<size_t>(index) >= num_enabled_entities) {
+        SwapEntities(index, static_cast<int>(num_enabled_entities));
+        entities[num_enabled_entities] = entity;
+        num_enabled_entities++;
+
+        if (is_tracking_new_entities) {
+            new_entities.push_back(entity);
+        }
+    }
+}
+
+bool System::HasEntity(Entity entity) const {
+    const auto entity_id = entity.GetId();
+    return static_cast<size_t>(entity_id) < entity_indices.size() && entity_indices[entity_id] != -1;
+}
+
+EntityView System::GetSystemEntities() const {
+    return EntityView(entities.data(), entities.data() + num_enabled_entities);
 }
 
 const Signature& System::GetComponentSignature() const {
     return component_signature;
 }
 
+void System::RequireExclusiveAccess() {
+    is_exclusive = true;
+}
+
+void System::TrackNewEntities() {
+    is_tracking_new_entities = true;
+}
+
+const Signature& System::GetReadSignature() const {
+    return read_signature;
+}
+
+const Signature& System::GetWriteSignature() const {
+    return write_signature;
+}
+
+bool System::IsExclusive() const {
+    return is_exclusive;
+}
+
+bool System::ConflictsWith(const System& other) const {
+    if (is_exclusive || other.is_exclusive) {
+        return true;
+    }
+    // Two readers never conflict, a writer conflicts with any other access to the same component.
+    const Signature other_access = other.read_signature | other.write_signature;
+    const Signature access = read_signature | write_signature;
+    return !(write_signature & other_access).none() || !(other.write_signature & access).none();
+}
+
+/*
+* Command Buffer
+*/
+CommandBuffer::~CommandBuffer() {
+    Clear();
+}
+
+void* CommandBuffer::Allocate(size_t size, size_t alignment) {
+    // Bump allocate in the current block, moving on to the next block when it is full.
+    while (current_block < blocks.size()) {
+        const size_t offset = (current_block_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= blocks[current_block].size) {
+            current_block_offset = offset + size;
+            return reinterpret_cast<unsigned char*>(blocks[current_block].memory.get()) + offset;
+        }
+        current_block++;
+        current_block_offset = 0;
+    }
+
+    const size_t block_size = std::max(size, COMMAND_BUFFER_BLOCK_SIZE);
+    const size_t num_elements = (block_size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+    blocks.push_back({ std::unique_ptr<std::max_align_t[]>(new std::max_align_t[num_elements]), block_size });
+    current_block_offset = size;
+    return blocks.back().memory.get();
+}
+
+void CommandBuffer::Record(CommandType type, int component_id, Entity entity, void (*apply)(Registry&, Entity, void*), void (*destroy)(void*), void* data) {
+    commands.push_back({ type, component_id, entity.GetId(), entity.GetGeneration(), apply, destroy, data });
+}
+
+Entity CommandBuffer::ResolveEntity(int entity_id, int entity_generation) const {
+    if (entity_id < 0) {
+        return created_entities[-entity_id - 1];
+    }
+    return Entity(entity_id, entity_generation);
+}
+
+void CommandBuffer::Clear() {
+    for (auto& command : commands) {
+        if (command.destroy) {
+            command.destroy(command.data);
+        }
+    }
+    commands.clear();
+    current_block = 0;
+    current_block_offset = 0;
+    created_entity_prefabs.clear();
+    created_entities.clear();
+}
+
+Entity CommandBuffer::CreateEntity() {
+    created_entity_prefabs.push_back(nullptr);
+    return Entity(-static_cast<int>(created_entity_prefabs.size()));
+}
+
+Entity CommandBuffer::Spawn(const Prefab& prefab) {
+    created_entity_prefabs.push_back(&prefab);
+    return Entity(-static_cast<int>(created_entity_prefabs.size()));
+}
+
+void CommandBuffer::TagEntity(Entity entity, TagId tag) {
+    void* data = new (Allocate(sizeof(TagId), alignof(TagId))) TagId(tag);
+    Record(COMMAND_TAG, -1, entity,
+        [](Registry& registry, Entity entity, void* data) { registry.TagEntity(entity, *static_cast<TagId*>(data)); },
+        nullptr, data);
+}
+
+void CommandBuffer::GroupEntity(Entity entity, GroupId group) {
+    void* data = new (Allocate(sizeof(GroupId), alignof(GroupId))) GroupId(group);
+    Record(COMMAND_GROUP, -1, entity,
+        [](Registry& registry, Entity entity, void* data) { registry.GroupEntity(entity, *static_cast<GroupId*>(data)); },
+        nullptr, data);
+}
+
+void CommandBuffer::KillEntity(Entity entity) {
+    Record(COMMAND_KILL, -1, entity,
+        [](Registry& registry, Entity entity, void*) { registry.entities_to_be_killed.push_back(entity); },
+        nullptr, nullptr);
+}
+
+/*
+* Archetype Storage
+*/
+Archetype::Archetype(const Signature& signature, const std::vector<const ComponentTypeInfo*>& component_types)
+    : signature(signature), column_per_component(MAX_COMPONENTS, -1), add_edges(MAX_COMPONENTS, nullptr), remove_edges(MAX_COMPONENTS, nullptr) {
+    size_t row_size = sizeof(int);
+    size_t alignment_padding = 0;
+    for (size_t component_id = 0; component_id < MAX_COMPONENTS; component_id++) {
+        if (signature.test(component_id)) {
+            column_per_component[component_id] = static_cast<int>(column_component_ids.size());
+            column_component_ids.push_back(static_cast<int>(component_id));
+            column_types.push_back(component_types[component_id]);
+            row_size += component_types[component_id]->size;
+            alignment_padding += component_types[component_id]->alignment - 1;
+        }
+    }
+
+    // Fit as many rows as possible in a chunk (big archetypes get a bigger chunk, holding at least one row).
+    chunk_size = std::max(ARCHETYPE_CHUNK_SIZE, row_size + alignment_padding);
+    chunk_capacity = static_cast<int>((chunk_size - alignment_padding) / row_size);
+
+    // The entity id column comes first, then each component column at its own alignment.
+    size_t offset = sizeof(int) * chunk_capacity;
+    for (auto type : column_types) {
+        offset = (offset + type->alignment - 1) / type->alignment * type->alignment;
+        column_offsets.push_back(offset);
+        offset += type->size * chunk_capacity;
+    }
+}
+
+Archetype::~Archetype() {
+    // Destroy the components that are still alive.
+    for (int chunk = 0; chunk < num_chunks_in_use; chunk++) {
+        for (int row = 0; row < chunks[chunk].count; row++) {
+            for (size_t column = 0; column < column_types.size(); column++) {
+                column_types[column]->destroy(GetComponent(static_cast<int>(column), chunk, row));
+            }
+        }
+    }
+}
+
+void Archetype::AllocateRow(int entity_id, int& chunk, int& row) {
+    if (num_chunks_in_use == 0 || chunks[num_chunks_in_use - 1].count == chunk_capacity) {
+        if (num_chunks_in_use == static_cast<int>(chunks.size())) {
+            ArchetypeChunk new_chunk;
+            new_chunk.memory = std::make_unique<std::max_align_t[]>((chunk_size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+            chunks.push_back(std::move(new_chunk));
+        }
+        num_chunks_in_use++;
+    }
+    chunk = num_chunks_in_use - 1;
+    row = chunks[chunk].count++;
+    GetEntityIds(chunk)[row] = entity_id;
+}
+
+int Archetype::RemoveRow(int chunk, int row) {
+    for (size_t column = 0; column < column_types.size(); column++) {
+        column_types[column]->destroy(GetComponent(static_cast<int>(column), chunk, row));
+    }
+
+    // Fill the hole with the last row, so that every chunk but the last one stays full.
+    const int last_chunk = num_chunks_in_use - 1;
+    const int last_row = chunks[last_chunk].count - 1;
+    int moved_entity_id = -1;
+    if (chunk != last_chunk || row != last_row) {
+        for (size_t column = 0; column < column_types.size(); column++) {
+            void* last_component = GetComponent(static_cast<int>(column), last_chunk, last_row);
+            column_types[column]->move_construct(GetComponent(static_cast<int>(column), chunk, row), last_component);
+            column_types[column]->destroy(last_component);
+        }
+        moved_entity_id = GetEntityIds(last_chunk)[last_row];
+        GetEntityIds(chunk)[row] = moved_entity_id;
+    }
+
+    if (--chunks[last_chunk].count == 0) {
+        num_chunks_in_use--;
+    }
+    return moved_entity_id;
+}
+
+Archetype* ArchetypeStorage::GetOrCreateArchetype(const Signature& signature) {
+    auto archetype = archetype_per_signature.find(signature);
+    if (archetype != archetype_per_signature.end()) {
+        return archetype->second;
+    }
+    archetypes.push_back(std::make_unique<Archetype>(signature, component_types));
+    archetype_per_signature.emplace(signature, archetypes.back().get());
+    return archetypes.back().get();
+}
+
+void ArchetypeStorage::MoveEntity(int entity_id, Archetype* target) {
+    EntityLocation& location = entity_locations[entity_id];
+    Archetype* source = location.archetype;
+
+    int target_chunk = 0;
+    int target_row = 0;
+    if (target) {
+        target->AllocateRow(entity_id, target_chunk, target_row);
+    }
+
+    if (source) {
+        // Move the components that both archetypes share, RemoveRow() destroys what is left behind.
+        if (target) {
+            for (int component_id : source->GetColumnComponentIds()) {
+                const int target_column = target->GetColumn(component_id);
+                if (target_column != -1) {
+                    component_types[component_id]->move_construct(
+                        target->GetComponent(target_column, target_chunk, target_row),
+                        source->GetComponent(source->GetColumn(component_id), location.chunk, location.row)
+                    );
+                }
+            }
+        }
+        const int moved_entity_id = source->RemoveRow(location.chunk, location.row);
+        if (moved_entity_id != -1) {
+            entity_locations[moved_entity_id].chunk = location.chunk;
+            entity_locations[moved_entity_id].row = location.row;
+        }
+    }
+
+    location.archetype = target;
+    location.chunk = target_chunk;
+    location.row = target_row;
+}
+
+void* ArchetypeStorage::AddComponent(int entity_id, int component_id) {
+    if (static_cast<size_t>(entity_id) >= entity_locations.size()) {
+        entity_locations.resize(entity_id + 1);
+    }
+    Archetype* source = entity_locations[entity_id].archetype;
+
+    // Follow the cached transition, or find the archetype of the new signature.
+    Archetype* target = source ? source->add_edges[component_id] : nullptr;
+    if (!target) {
+        Signature signature = source ? source->GetSignature() : Signature();
+        signature.set(component_id);
+        target = GetOrCreateArchetype(signature);
+        if (source) {
+            source->add_edges[component_id] = target;
+        }
+    }
+
+    // The new component column is left uninitialized by the move.
+    MoveEntity(entity_id, target);
+    const auto& location = entity_locations[entity_id];
+    return target->GetComponent(target->GetColumn(component_id), location.chunk, location.row);
+}
+
+void ArchetypeStorage::AddEntities(const Entity* entities, int count, const Signature& signature) {
+    if (signature == Signature()) {
+        return;
+    }
+    Archetype* target = GetOrCreateArchetype(signature);
+    for (int i = 0; i < count; i++) {
+        const auto entity_id = entities[i].GetId();
+        if (static_cast<size_t>(entity_id) >= entity_locations.size()) {
+            entity_locations.resize(entity_id + 1);
+        }
+        MoveEntity(entity_id, target);
+    }
+}
+
+void ArchetypeStorage::RemoveComponent(int entity_id, int component_id) {
+    Archetype* source = entity_locations[entity_id].archetype;
+    Archetype* target = source->remove_edges[component_id];
+    if (!target) {
+        Signature signature = source->GetSignature();
+        signature.reset(component_id);
+        target = signature.none() ? nullptr : GetOrCreateArchetype(signature);
+        source->remove_edges[component_id] = target;
+    }
+    MoveEntity(entity_id, target);
+}
+
+void ArchetypeStorage::RemoveEntity(int entity_id) {
+    if (static_cast<size_t>(entity_id) < entity_locations.size()) {
+        MoveEntity(entity_id, nullptr);
+    }
+}
+
 Entity Registry::CreateEntity() {
     int entity_id;
 
@@ -50,15 +445,24 @@ Entity Registry::CreateEntity() {
         entity_id = num_entities++;
         if (static_cast<size_t>(entity_id) >= entity_component_signatures.size()) {
             entity_component_signatures.resize(entity_id + 1);
+            entity_generations.resize(entity_id + 1, 0);
+            entity_tags.resize(entity_id + 1, -1);
+            entity_groups.resize(entity_id + 1, 0);
+            entity_systems.resize(entity_id + 1, 0);
+            entity_systems_to_update.resize(entity_id + 1, 0);
+            entity_prefab_ids.resize(entity_id + 1, -1);
         }
     } else {
-        entity_id = free_ids.front();
-        free_ids.pop_front();
+        entity_id = free_ids.back();
+        free_ids.pop_back();
     }
 
-    Entity entity(entity_id);
+    Entity entity(entity_id, entity_generations[entity_id]);
     entity.registry = this;
-    entities_to_be_added.insert(entity);
+    entities_to_be_added.push_back(entity);
+    entity_prefab_ids[entity_id] = -1;
+    // New entities are matched against every system when they are added, so their components are not tracked one by one.
+    entity_systems_to_update[entity_id] = ~uint64_t(0);
 
     //Logger::Log("Entity created with id = " + std::to_string(entity_id));
 
@@ -66,114 +470,617 @@ Entity Registry::CreateEntity() {
 }
 
 void Registry::KillEntity(Entity entity) {
-    entities_to_be_killed.insert(entity);
+    // Ignore stale handles to an entity that was already destroyed.
+    if (!IsAlive(entity)) {
+        return;
+    }
+    GetCommandBuffer().KillEntity(entity);
 }
 
 /*
 * Tag Management
 */
+NameTable& Registry::GetTagNames() {
+    static NameTable tag_names;
+    return tag_names;
+}
+
+TagId Registry::GetTagId(const std::string& tag) {
+    return GetTagNames().Intern(tag);
+}
+
+void Registry::TagEntity(Entity entity, TagId tag) {
+    // Ignore stale handles, the id may belong to another entity by now.
+    if (tag < 0 || !IsAlive(entity)) {
+        return;
+    }
+    if (static_cast<size_t>(tag) >= entity_per_tag.size()) {
+        entity_per_tag.resize(tag + 1, Entity(-1));
+    }
+
+    // Take the tag away from its previous entity, and the previous tag away from the entity.
+    const Entity previous_entity = entity_per_tag[tag];
+    if (previous_entity.GetId() != -1) {
+        entity_tags[previous_entity.GetId()] = -1;
+    }
+    RemoveEntityTag(entity);
+
+    entity_per_tag[tag] = entity;
+    entity_tags[entity.GetId()] = tag;
+}
+
 void Registry::TagEntity(Entity entity, const std::string& tag) {
-    entity_per_tag.emplace(tag, entity);
-    tag_per_entity.emplace(entity.GetId(), tag);
+    TagEntity(entity, GetTagId(tag));
 }
 
 bool Registry::EntityHasTag(Entity entity, const std::string& tag) const {
-    if (tag_per_entity.find(entity.GetId()) == tag_per_entity.end()) {
-        return false;
+    const TagId tag_id = GetTagNames().Find(tag);
+    return tag_id != -1 && EntityHasTag(entity, tag_id);
+}
+
+Entity Registry::GetEntityByTag(TagId tag) const {
+    if (tag < 0 || static_cast<size_t>(tag) >= entity_per_tag.size()) {
+        return Entity(-1);
     }
-    return entity_per_tag.find(tag)->second == entity;
+    return entity_per_tag[tag];
 }
 
 Entity Registry::GetEntityByTag(const std::string& tag) const {
-    return entity_per_tag.at(tag);
+    return GetEntityByTag(GetTagNames().Find(tag));
 }
 
 void Registry::RemoveEntityTag(Entity entity) {
-    auto tagged_entity = tag_per_entity.find(entity.GetId());
-    if (tagged_entity != tag_per_entity.end()) {
-        auto tag = tagged_entity->second;
-        entity_per_tag.erase(tag);
-        tag_per_entity.erase(tagged_entity);
+    const TagId tag = entity_tags[entity.GetId()];
+    if (tag != -1) {
+        entity_per_tag[tag] = Entity(-1);
+        entity_tags[entity.GetId()] = -1;
     }
 }
 
 /*
 * Group Management
 */
+NameTable& Registry::GetGroupNames() {
+    static NameTable group_names;
+    return group_names;
+}
+
+GroupId Registry::GetGroupId(const std::string& group) {
+    const GroupId group_id = GetGroupNames().Intern(group);
+    if (group_id >= MAX_GROUPS) {
+        // Systems look their groups up once, but level scripts may ask for the same group for every entity.
+        static std::mutex mutex;
+        static std::unordered_set<std::string> reported_groups;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (reported_groups.insert(group).second) {
+            Logger::Err("Too many entity groups, at most " + std::to_string(MAX_GROUPS) + " can be used: group " + group + " has no id");
+        }
+        return -1;
+    }
+    return group_id;
+}
+
+// Adding to a group that has no id would silently lose the membership, so it is a fatal error.
+static void CheckGroupId(GroupId group) {
+    if (group < 0 || group >= MAX_GROUPS) {
+        Logger::Err("Invalid entity group id " + std::to_string(group) + ", see the previous errors for the group name");
+        std::abort();
+    }
+}
+
+void Registry::GroupEntity(Entity entity, GroupId group) {
+    CheckGroupId(group);
+    // Ignore stale handles, the id may belong to another entity by now.
+    if (!IsAlive(entity) || EntityBelongsToGroup(entity, group)) {
+        return;
+    }
+    if (static_cast<size_t>(group) >= groups.size()) {
+        groups.resize(group + 1);
+    }
+
+    auto& entity_group = groups[group];
+    const auto entity_id = entity.GetId();
+    if (static_cast<size_t>(entity_id) >= entity_group.entity_indices.size()) {
+        entity_group.entity_indices.resize(entity_id + 1, -1);
+    }
+    entity_group.entity_indices[entity_id] = static_cast<int>(entity_group.entities.size());
+    entity_group.entities.push_back(entity);
+    entity_groups[entity_id] |= uint64_t(1) << group;
+}
+
 void Registry::GroupEntity(Entity entity, const std::string& group) {
-    entities_per_group.emplace(group, std::set<Entity>());
-    entities_per_group[group].emplace(entity);
-    group_per_entity.emplace(entity.GetId(), group);
+    GroupEntity(entity, GetGroupId(group));
 }
 
 bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const {
-    if (entities_per_group.find(group) == entities_per_group.end()) {
-        return false;
+    const GroupId group_id = GetGroupNames().Find(group);
+    return group_id != -1 && group_id < MAX_GROUPS && EntityBelongsToGroup(entity, group_id);
+}
+
+EntityView Registry::GetEntitiesByGroup(GroupId group) const {
+    if (group < 0 || static_cast<size_t>(group) >= groups.size()) {
+        return EntityView(nullptr, nullptr);
     }
-    auto group_entities = entities_per_group.at(group);
-    return group_entities.find(entity.GetId()) != group_entities.end();
+    const auto& entities = groups[group].entities;
+    return EntityView(entities.data(), entities.data() + entities.size());
 }
 
-std::vector<Entity> Registry::GetEntitiesByGroup(const std::string& group) const {
-    auto& set_of_entities = entities_per_group.at(group);
-    return std::vector<Entity>(set_of_entities.begin(), set_of_entities.end());
+EntityView Registry::GetEntitiesByGroup(const std::string& group) const {
+    const GroupId group_id = GetGroupNames().Find(group);
+    return group_id < MAX_GROUPS ? GetEntitiesByGroup(group_id) : EntityView(nullptr, nullptr);
 }
 
 void Registry::RemoveEntityGroup(Entity entity) {
-    // if in group, remove entity from group management.
-    auto grouped_entity = group_per_entity.find(entity.GetId());
-    if (grouped_entity != group_per_entity.end()) {
-        auto group = entities_per_group.find(grouped_entity->second);
-        if (group != entities_per_group.end()) {
-            auto entity_in_group = group->second.find(entity);
-            if (entity_in_group != group->second.end()) {
-                group->second.erase(entity_in_group);
-            }
+    // Remove the entity from every group it belongs to, keeping the group members packed.
+    const auto entity_id = entity.GetId();
+    uint64_t group_mask = entity_groups[entity_id];
+    while (group_mask != 0) {
+        const int group = LowestSetBit(group_mask);
+        group_mask &= group_mask - 1;
+
+        auto& entity_group = groups[group];
+        const int index_of_removed = entity_group.entity_indices[entity_id];
+        const Entity last = entity_group.entities.back();
+        entity_group.entities[index_of_removed] = last;
+        entity_group.entity_indices[last.GetId()] = index_of_removed;
+        entity_group.entity_indices[entity_id] = -1;
+        entity_group.entities.pop_back();
+    }
+    entity_groups[entity_id] = 0;
+}
+
+void Registry::RebuildSystemTable() {
+    system_table.clear();
+    system_signatures.clear();
+    for (auto& system : systems) {
+        system_table.push_back(system.second.get());
+        system_signatures.push_back(system.second->GetComponentSignature());
+    }
+    if (system_table.size() > MAX_SYSTEMS) {
+        Logger::Err("Too many systems: only " + std::to_string(MAX_SYSTEMS) + " systems are supported.");
+        system_table.resize(MAX_SYSTEMS);
+        system_signatures.resize(MAX_SYSTEMS);
+    }
+    all_systems = system_table.size() == MAX_SYSTEMS ? ~uint64_t(0) : (uint64_t(1) << system_table.size()) - 1;
+
+    std::fill(systems_per_component.begin(), systems_per_component.end(), 0);
+    for (size_t i = 0; i < system_signatures.size(); i++) {
+        system_signatures[i].ForEachSetBit([this, i](int component_id) {
+            systems_per_component[component_id] |= uint64_t(1) << i;
+        });
+    }
+
+    // The table order changed, so rebuild the membership masks from the entity lists of the systems.
+    std::fill(entity_systems.begin(), entity_systems.end(), 0);
+    for (size_t i = 0; i < system_table.size(); i++) {
+        for (auto entity : system_table[i]->entities) {
+            entity_systems[entity.GetId()] |= uint64_t(1) << i;
         }
-        group_per_entity.erase(grouped_entity);
+    }
+    for (auto entity_id : entities_to_be_updated) {
+        entity_systems_to_update[entity_id] = ~uint64_t(0);
     }
 }
 
-void Registry::AddEntityToSystems(Entity entity) {
+void Registry::MarkEntitySystemsToUpdate(int entity_id, uint64_t system_mask) {
+    // Components that no system requires do not change any membership.
+    if (system_mask == 0) {
+        return;
+    }
+    uint64_t& systems_to_update = entity_systems_to_update[entity_id];
+    if (systems_to_update == 0) {
+        entities_to_be_updated.push_back(entity_id);
+    }
+    systems_to_update |= system_mask;
+}
+
+void Registry::UpdateEntitySystems(Entity entity, uint64_t system_mask) {
     const auto entity_id = entity.GetId();
-    // Match entity_component_signature <--> system_component_signature.
+    // Match entity_component_signature <--> system_component_signature, only for the systems in the mask.
     const auto& entity_component_signature = entity_component_signatures[entity_id];
-    // Loop all the systems.
-    for (auto& system : systems) {
-        const auto& system_component_signature = system.second->GetComponentSignature();
-        bool is_interested = (entity_component_signature & system_component_signature) == system_component_signature;
-        if (is_interested) {
-            system.second->AddEntityToSystem(entity);
+    uint64_t& member_systems = entity_systems[entity_id];
+    for (uint64_t mask = system_mask & all_systems; mask != 0; mask &= mask - 1) {
+        const int i = LowestSetBit(mask);
+        const uint64_t system_bit = uint64_t(1) << i;
+        const bool is_member = (member_systems & system_bit) != 0;
+        if (entity_component_signature.Contains(system_signatures[i])) {
+            if (!is_member) {
+                system_table[i]->AddEntityToSystem(entity);
+                member_systems |= system_bit;
+            }
+        } else if (is_member) {
+            system_table[i]->RemoveEntityFromSystem(entity);
+            member_systems &= ~system_bit;
         }
     }
 }
 
+void Registry::AddEntityToSystems(Entity entity) {
+    UpdateEntitySystems(entity, all_systems);
+}
+
 void Registry::RemoveEntityFromSystems(Entity entity) {
-    for (auto system : systems) {
-        system.second->RemoveEntityFromSystem(entity);
+    // Only visit the systems the entity belongs to, the others cannot contain it.
+    uint64_t& member_systems = entity_systems[entity.GetId()];
+    for (uint64_t mask = member_systems; mask != 0; mask &= mask - 1) {
+        system_table[LowestSetBit(mask)]->RemoveEntityFromSystem(entity);
+    }
+    member_systems = 0;
+}
+
+void Registry::ApplyCommandBuffers() {
+    // Create the deferred entities first, so the other commands can refer to them.
+    // Consecutive entities spawned from the same prefab are spawned in one batch.
+    for (unsigned int i = 0; i < command_buffers.GetSize(); i++) {
+        auto& command_buffer = command_buffers[i];
+        const auto& created_entity_prefabs = command_buffer.created_entity_prefabs;
+        size_t j = 0;
+        while (j < created_entity_prefabs.size()) {
+            const Prefab* prefab = created_entity_prefabs[j];
+            size_t run_end = j + 1;
+            while (run_end < created_entity_prefabs.size() && created_entity_prefabs[run_end] == prefab) {
+                run_end++;
+            }
+            if (prefab) {
+                SpawnEntities(*prefab, static_cast<int>(run_end - j), command_buffer.created_entities);
+            } else {
+                for (size_t k = j; k < run_end; k++) {
+                    command_buffer.created_entities.push_back(CreateEntity());
+                }
+            }
+            j = run_end;
+        }
+    }
+
+    // Sort the commands by type, component and entity so consecutive commands touch the same storage.
+    // The recording order is kept between commands on the same component of the same entity.
+    pending_commands.clear();
+    for (unsigned int i = 0; i < command_buffers.GetSize(); i++) {
+        const auto& command_buffer = command_buffers[i];
+        for (const auto& command : command_buffer.commands) {
+            Entity entity = command_buffer.ResolveEntity(command.entity_id, command.entity_generation);
+            entity.registry = this;
+            pending_commands.push_back({ &command, entity, pending_commands.size() });
+        }
+    }
+    std::sort(pending_commands.begin(), pending_commands.end(), [](const PendingCommand& a, const PendingCommand& b) {
+        return std::make_tuple(a.command->type, a.command->component_id, a.entity.GetId(), a.sequence) <
+            std::make_tuple(b.command->type, b.command->component_id, b.entity.GetId(), b.sequence);
+    });
+
+    for (const auto& pending_command : pending_commands) {
+        // Skip commands on entities that were destroyed since they were recorded.
+        if (!IsAlive(pending_command.entity)) {
+            continue;
+        }
+        pending_command.command->apply(*this, pending_command.entity, pending_command.command->data);
+    }
+    pending_commands.clear();
+
+    for (unsigned int i = 0; i < command_buffers.GetSize(); i++) {
+        command_buffers[i].Clear();
+    }
+}
+
+int Prefab::next_id = 0;
+
+Prefab::Prefab(const Prefab& other) :
+    signature(other.signature), group_mask(other.group_mask), components(other.components), is_recyclable(other.is_recyclable), id(next_id++) {
+}
+
+Prefab& Prefab::operator =(const Prefab& other) {
+    signature = other.signature;
+    group_mask = other.group_mask;
+    components = other.components;
+    is_recyclable = other.is_recyclable;
+    id = next_id++;
+    return *this;
+}
+
+void Prefab::Group(GroupId group) {
+    CheckGroupId(group);
+    group_mask |= uint64_t(1) << group;
+}
+
+void Prefab::Group(const std::string& group) {
+    Group(Registry::GetGroupId(group));
+}
+
+void Registry::SpawnEntities(const Prefab& prefab, int count, std::vector<Entity>& entities) {
+    const size_t first = entities.size();
+
+    // Reuse the parked entities of a recyclable prefab first: they already have the prefab components and systems.
+    // They stay disabled until the next Update(), since systems may be running.
+    int num_reused = 0;
+    if (prefab.is_recyclable) {
+        auto& prefab_entities = recycled_entities[prefab.id];
+        prefab_entities.signature = prefab.signature;
+        auto& parked_ids = prefab_entities.parked_entity_ids;
+        // Reserve for the whole batch, still growing geometrically since spawns often reuse one entity at a time.
+        const size_t num_to_be_enabled = entities_to_be_enabled.size() + std::min(static_cast<size_t>(count), parked_ids.size());
+        if (num_to_be_enabled > entities_to_be_enabled.capacity()) {
+            entities_to_be_enabled.reserve(std::max(num_to_be_enabled, entities_to_be_enabled.capacity() * 2));
+        }
+        for (; num_reused < count && !parked_ids.empty(); num_reused++) {
+            const int entity_id = parked_ids.back();
+            parked_ids.pop_back();
+
+            Entity entity(entity_id, entity_generations[entity_id]);
+            entity.registry = this;
+            entities_to_be_enabled.push_back(entity);
+            entities.push_back(entity);
+        }
+        for (const auto& component : prefab.components) {
+            component.overwrite(*this, component.value.get(), entities.data() + first, num_reused);
+        }
+    }
+
+    const int num_created = count - num_reused;
+    for (int i = 0; i < num_created; i++) {
+        entities.push_back(CreateEntity());
+    }
+    const Entity* new_entities = entities.data() + first + num_reused;
+
+    // The new entities have no components yet: they get the prefab signature as a whole.
+    for (int i = 0; i < num_created; i++) {
+        entity_component_signatures[new_entities[i].GetId()] = prefab.signature;
+        if (prefab.is_recyclable) {
+            entity_prefab_ids[new_entities[i].GetId()] = prefab.id;
+        }
+    }
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Place every entity in the archetype of the prefab, then construct the component columns.
+    for (const auto& component : prefab.components) {
+        archetype_storage.RegisterComponentType(component.component_id, component.type);
+    }
+    archetype_storage.AddEntities(new_entities, num_created, prefab.signature);
+#endif
+    for (const auto& component : prefab.components) {
+        component.spawn(*this, component.value.get(), new_entities, num_created);
+    }
+
+    for (uint64_t group_mask = prefab.group_mask; group_mask != 0; group_mask &= group_mask - 1) {
+        const GroupId group = LowestSetBit(group_mask);
+        for (int i = 0; i < count; i++) {
+            GroupEntity(entities[first + i], group);
+        }
+    }
+}
+
+void Registry::ParkEntity(Entity entity) {
+    const auto entity_id = entity.GetId();
+
+    // The entity keeps its components and its place in the systems, it is only disabled.
+    for (uint64_t mask = entity_systems[entity_id]; mask != 0; mask &= mask - 1) {
+        system_table[LowestSetBit(mask)]->DisableEntityInSystem(entity);
+    }
+#ifdef ECS_ARCHETYPE_STORAGE
+    archetype_storage.RegisterComponentType(Component<DisabledComponent>::GetId(), ComponentTypeInfo::Get<DisabledComponent>());
+    new (archetype_storage.AddComponent(entity_id, Component<DisabledComponent>::GetId())) DisabledComponent();
+#endif
+    entity_component_signatures[entity_id].set(Component<DisabledComponent>::GetId());
+
+    // Invalidate every outstanding handle, like for a destroyed entity.
+    entity_generations[entity_id]++;
+    RemoveEntityTag(entity);
+    RemoveEntityGroup(entity);
+
+    recycled_entities[entity_prefab_ids[entity_id]].parked_entity_ids.push_back(entity_id);
+}
+
+void Registry::EnableParkedEntity(Entity entity) {
+    const auto entity_id = entity.GetId();
+#ifdef ECS_ARCHETYPE_STORAGE
+    archetype_storage.RemoveComponent(entity_id, Component<DisabledComponent>::GetId());
+#endif
+    entity_component_signatures[entity_id].reset(Component<DisabledComponent>::GetId());
+    for (uint64_t mask = entity_systems[entity_id]; mask != 0; mask &= mask - 1) {
+        system_table[LowestSetBit(mask)]->EnableEntityInSystem(entity);
+    }
+}
+
+void Registry::DestroyParkedEntities(RecycledEntities& prefab_entities, size_t num_kept) {
+    auto& parked_ids = prefab_entities.parked_entity_ids;
+    for (size_t i = num_kept; i < parked_ids.size(); i++) {
+        const int entity_id = parked_ids[i];
+        // Not the prefab's entity anymore, so the kill in Update() destroys it instead of parking it again.
+        entity_prefab_ids[entity_id] = -1;
+        Entity entity(entity_id, entity_generations[entity_id]);
+        entity.registry = this;
+        entities_to_be_killed.push_back(entity);
+    }
+    if (parked_ids.size() > num_kept) {
+        parked_ids.resize(num_kept);
+    }
+}
+
+void Registry::ReleasePrefab(const Prefab& prefab) {
+    auto prefab_entities = recycled_entities.find(prefab.id);
+    if (prefab_entities != recycled_entities.end()) {
+        DestroyParkedEntities(prefab_entities->second, 0);
+        recycled_entities.erase(prefab_entities);
+    }
+}
+
+void Registry::TrimParkedEntities(const Prefab& prefab, int max_parked_entities) {
+    auto prefab_entities = recycled_entities.find(prefab.id);
+    if (prefab_entities != recycled_entities.end()) {
+        DestroyParkedEntities(prefab_entities->second, std::max(max_parked_entities, 0));
+    }
+}
+
+Entity Registry::Spawn(const Prefab& prefab) {
+    SpawnEntities(prefab, 1, spawned_entities);
+    const Entity entity = spawned_entities.back();
+    spawned_entities.pop_back();
+    return entity;
+}
+
+void Registry::AddPrefab(const std::string& name, Prefab prefab) {
+    auto previous_prefab = prefabs.find(name);
+    if (previous_prefab != prefabs.end()) {
+        ReleasePrefab(previous_prefab->second);
+    }
+    prefabs[name] = std::move(prefab);
+}
+
+void Registry::RemovePrefabs() {
+    for (const auto& prefab : prefabs) {
+        ReleasePrefab(prefab.second);
+    }
+    prefabs.clear();
+}
+
+const Prefab* Registry::GetPrefab(const std::string& name) const {
+    auto prefab = prefabs.find(name);
+    return prefab != prefabs.end() ? &prefab->second : nullptr;
+}
+
+ComponentChanges::ComponentChanges(uint32_t current_tick, unsigned int num_threads) : tick(current_tick) {
+    changed_entity_ids.Resize(num_threads);
+}
+
+void ComponentChanges::BeginTick(uint32_t current_tick) {
+    const size_t first = changes.size();
+    for (unsigned int i = 0; i < changed_entity_ids.GetSize(); i++) {
+        for (int entity_id : changed_entity_ids[i]) {
+            changes.push_back({tick, entity_id});
+        }
+        changed_entity_ids[i].clear();
+    }
+    std::sort(changes.begin() + first, changes.end(), [](const Change& a, const Change& b) {
+        return a.entity_id < b.entity_id;
+    });
+
+    // Drop the records of the entities that changed again once the log is about twice the number of entities.
+    if (changes.size() > 2 * versions.size() + 1024) {
+        changes.erase(std::remove_if(changes.begin(), changes.end(), [this](const Change& change) {
+            return versions[change.entity_id] != change.tick;
+        }), changes.end());
+    }
+    tick = current_tick;
+}
+
+const std::vector<int>& ComponentChanges::FindChangedEntityIds(uint32_t since_tick) {
+    found_entity_ids.clear();
+    auto change = std::upper_bound(changes.begin(), changes.end(), since_tick, [](uint32_t since_tick, const Change& change) {
+        return since_tick < change.tick;
+    });
+    for (; change != changes.end(); ++change) {
+        if (versions[change->entity_id] == change->tick) {
+            found_entity_ids.push_back(change->entity_id);
+        }
+    }
+    if (tick > since_tick) {
+        for (unsigned int i = 0; i < changed_entity_ids.GetSize(); i++) {
+            found_entity_ids.insert(found_entity_ids.end(), changed_entity_ids[i].begin(), changed_entity_ids[i].end());
+        }
+    }
+    // Every entity has a single record of its last change, so there are no duplicates.
+    std::sort(found_entity_ids.begin(), found_entity_ids.end());
+    return found_entity_ids;
+}
+
+void Registry::ReserveCommandBuffers(unsigned int num_threads) {
+    command_buffers.Resize(num_threads);
+    for (auto& changes : component_changes) {
+        if (changes) {
+            changes->SetNumThreads(num_threads);
+        }
     }
 }
 
 void Registry::Update() {
+    // Start a new tick: the changes recorded from now on belong to it.
+    tick++;
+    for (auto& changes : component_changes) {
+        if (changes) {
+            changes->BeginTick(tick);
+        }
+    }
+
+    // Apply the changes recorded by the systems since the last update.
+    ApplyCommandBuffers();
+
+    // Enable the parked entities that spawns reused.
+    for (auto entity : entities_to_be_enabled) {
+        EnableParkedEntity(entity);
+    }
+    entities_to_be_enabled.clear();
+
     // Add the entities that are waiting to be created to the active Systems.
+    std::sort(entities_to_be_added.begin(), entities_to_be_added.end());
     for (auto& entity : entities_to_be_added) {
         AddEntityToSystems(entity);
+        entity_systems_to_update[entity.GetId()] = 0;
     }
     entities_to_be_added.clear();
 
+    // Match the live entities that gained components against the systems that require those components.
+    std::sort(entities_to_be_updated.begin(), entities_to_be_updated.end());
+    for (auto entity_id : entities_to_be_updated) {
+        Entity entity(entity_id, entity_generations[entity_id]);
+        entity.registry = this;
+        UpdateEntitySystems(entity, entity_systems_to_update[entity_id]);
+        entity_systems_to_update[entity_id] = 0;
+    }
+    entities_to_be_updated.clear();
+
+    // The entities left the systems of their removed components, drop the component data.
+    // Components added back in the meantime are kept.
+    for (const auto& removed_component : components_to_be_removed) {
+        const Entity entity = removed_component.entity;
+        const int component_id = removed_component.component_id;
+        if (!IsAlive(entity) || entity_component_signatures[entity.GetId()].test(component_id)) {
+            continue;
+        }
+#ifdef ECS_ARCHETYPE_STORAGE
+        if (archetype_storage.HasComponent(entity.GetId(), component_id)) {
+            archetype_storage.RemoveComponent(entity.GetId(), component_id);
+        }
+#else
+        component_pools[component_id]->RemoveEntityFromPool(entity.GetId());
+#endif
+    }
+    components_to_be_removed.clear();
+
     // Remove the entities that are waiting to be killed from the active Systems.
+    std::sort(entities_to_be_killed.begin(), entities_to_be_killed.end());
+    entities_to_be_killed.erase(std::unique(entities_to_be_killed.begin(), entities_to_be_killed.end()), entities_to_be_killed.end());
     for (auto entity : entities_to_be_killed) {
+        // Entities of a recyclable prefab are parked for reuse, unless their components changed since they were spawned.
+        const int prefab_id = entity_prefab_ids[entity.GetId()];
+        if (prefab_id != -1) {
+            auto prefab_entities = recycled_entities.find(prefab_id);
+            if (prefab_entities != recycled_entities.end() && entity_component_signatures[entity.GetId()] == prefab_entities->second.signature) {
+                ParkEntity(entity);
+                continue;
+            }
+        }
+
         RemoveEntityFromSystems(entity);
-        entity_component_signatures[entity.GetId()].reset();
 
-        // Remove the entity from the component pools.
-        for (auto pool : component_pools) {
-            if (pool) {
-                pool->RemoveEntityFromPool(entity.GetId());
+        // Remove the entity from the component storage.
+        // With pools, the kills are grouped per component the entity owns and removed in one batch below.
+#ifdef ECS_ARCHETYPE_STORAGE
+        archetype_storage.RemoveEntity(entity.GetId());
+#else
+        entity_component_signatures[entity.GetId()].ForEachSetBit([this, entity](int component_id) {
+            // Destroyed parked entities are still marked disabled, a marker that has no pool.
+            if (component_id == Component<DisabledComponent>::GetId()) {
+                return;
             }
-        }
+            if (static_cast<size_t>(component_id) >= killed_entity_ids_per_component.size()) {
+                killed_entity_ids_per_component.resize(component_id + 1);
+            }
+            killed_entity_ids_per_component[component_id].push_back(entity.GetId());
+        });
+#endif
+        entity_component_signatures[entity.GetId()].reset();
 
-        // Make the entity ID available to be reused.
+        // Invalidate every outstanding handle and make the entity ID available to be reused.
+        entity_generations[entity.GetId()]++;
         free_ids.push_back(entity.GetId());
 
         // Remove any traces of that entity from the tag/group maps.
@@ -181,4 +1088,15 @@ void Registry::Update() {
         RemoveEntityGroup(entity);
     }
     entities_to_be_killed.clear();
+
+#ifndef ECS_ARCHETYPE_STORAGE
+    // The kill list is sorted, so every id list is sorted too.
+    for (size_t component_id = 0; component_id < killed_entity_ids_per_component.size(); component_id++) {
+        auto& killed_entity_ids = killed_entity_ids_per_component[component_id];
+        if (!killed_entity_ids.empty()) {
+            component_pools[component_id]->RemoveMany(killed_entity_ids.data(), killed_entity_ids.size());
+            killed_entity_ids.clear();
+        }
+    }
+#endif
 }
\ No newline at end of file
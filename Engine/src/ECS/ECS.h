@@ -1,71 +1,269 @@
 #pragma once
 
-#include <bitset>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <set>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
 #include <typeindex>
 #include <unordered_map>
 #include <vector>
 
 #include "../Logger/Logger.h"
-#include <deque>
+#include "ComponentId.h"
+#include "../JobSystem/JobSystem.h"
 
 #include <iostream>
 
-const unsigned int MAX_COMPONENTS = 32;
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Component storage backend, selected at compile time:
+// - by default every component type lives in its own sparse-set Pool<T>;
+// - defining ECS_ARCHETYPE_STORAGE groups entities by signature into fixed-size chunks,
+//   with each component type laid out contiguously inside the chunk.
+
+// Index of the lowest set bit of a non-zero word.
+inline int LowestSetBit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#elif defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int index = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
 
-// We use a bitset (1s and 0s) to keep track of which components an entity has.
+// We use a bit mask (1s and 0s) to keep track of which components an entity has.
 // Also, this helps keep track of which entities a system is interested in.
-typedef std::bitset<MAX_COMPONENTS> Signature;
+// The bits are stored in 64-bit words, so matching two signatures compiles down to a few wide AND/compare instructions.
+// The lowercase methods follow the std::bitset interface.
+class alignas(32) Signature
+{
+private:
+    static const unsigned int NUM_WORDS = MAX_COMPONENTS / 64;
+    uint64_t words[NUM_WORDS] = {};
+
+public:
+    void set(size_t bit, bool value = true) {
+        const uint64_t mask = uint64_t(1) << (bit % 64);
+        words[bit / 64] = value ? (words[bit / 64] | mask) : (words[bit / 64] & ~mask);
+    }
+
+    void reset(size_t bit) {
+        set(bit, false);
+    }
+
+    void reset() {
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            words[i] = 0;
+        }
+    }
+
+    bool test(size_t bit) const {
+        return (words[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    bool none() const {
+        uint64_t bits = 0;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            bits |= words[i];
+        }
+        return bits == 0;
+    }
+
+    // Returns true if every bit of other is also set in this signature.
+    bool Contains(const Signature& other) const {
+        uint64_t missing = 0;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            missing |= other.words[i] & ~words[i];
+        }
+        return missing == 0;
+    }
+
+    Signature operator &(const Signature& other) const {
+        Signature result;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            result.words[i] = words[i] & other.words[i];
+        }
+        return result;
+    }
+
+    Signature operator |(const Signature& other) const {
+        Signature result;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            result.words[i] = words[i] | other.words[i];
+        }
+        return result;
+    }
+
+    bool operator ==(const Signature& other) const {
+        uint64_t different = 0;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            different |= words[i] ^ other.words[i];
+        }
+        return different == 0;
+    }
+
+    bool operator !=(const Signature& other) const {
+        return !(*this == other);
+    }
+
+    // Call func(bit) for every set bit, in increasing order.
+    template <typename TFunc>
+    void ForEachSetBit(TFunc&& func) const {
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            uint64_t word = words[i];
+            while (word != 0) {
+                func(static_cast<int>(i * 64) + LowestSetBit(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+    size_t Hash() const {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            hash = (hash ^ words[i]) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+namespace std
+{
+    template <>
+    struct hash<Signature>
+    {
+        size_t operator ()(const Signature& signature) const {
+            return signature.Hash();
+        }
+    };
+}
 
 struct IComponent
 {
 protected:
     static int next_id;
+
+    // Hands out the next dynamic id, and aborts once all MAX_COMPONENTS ids are taken
+    // since signatures and pools have no room for more.
+    static int GetNextId();
 };
 
 // Used to assign a unique id per component type.
+// Components registered with REGISTER_COMPONENT have a compile-time id, the others get one on first use.
 template <typename T>
 class Component : public IComponent
 {
 public:
     // Returns the unique id of Component<TComponent>
     static int GetId() {
-        static auto id = next_id++;
-        return id;
+        if constexpr (ComponentId<T>::value >= 0) {
+            return ComponentId<T>::value;
+        } else {
+            static auto id = GetNextId();
+            return id;
+        }
     }
 };
 
+// Tags and groups are interned to small integer ids (see Registry::GetTagId() and Registry::GetGroupId()).
+typedef int TagId;
+typedef int GroupId;
+
+// Group membership is a bit mask per entity, so there can be up to 64 groups.
+const int MAX_GROUPS = 64;
+
+// Maximum number of systems in a registry (system membership is a 64 bit mask per entity).
+const int MAX_SYSTEMS = 64;
+
+// Thread-safe table of interned names, id = index of the name.
+class NameTable
+{
+private:
+    std::unordered_map<std::string, int> ids_per_name;
+    mutable std::mutex mutex;
+
+public:
+    // Returns the id of name, adding it to the table if needed.
+    int Intern(const std::string& name);
+    // Returns the id of name, or -1 if it was never interned.
+    int Find(const std::string& name) const;
+};
+
+// An entity handle is an index plus the generation of that index when the handle was made.
+// Killing an entity bumps the generation of its index, so stale handles can be detected.
 class Entity
 {
 private:
     int id;
+    int generation;
 
 public:
-    Entity(int id) : id(id) {};
+    explicit Entity(int id, int generation = 0) : id(id), generation(generation) {};
     Entity(const Entity& entity) = default;
     void Kill();
+    bool IsAlive() const;
     int GetId() const;
+    int GetGeneration() const;
 
     // Manage entity tags and groups.
+    // The id overloads avoid hashing the name, resolve the ids once (e.g. in a system constructor).
     void Tag(const std::string& tag);
+    void Tag(TagId tag);
     bool HasTag(const std::string& tag) const;
+    bool HasTag(TagId tag) const;
     void Group(const std::string& group);
+    void Group(GroupId group);
     bool BelongsToGroup(const std::string& group) const;
+    bool BelongsToGroup(GroupId group) const;
 
     Entity& operator =(const Entity& other) = default;
-    bool operator ==(const Entity& other) const { return id == other.id; };
-    bool operator !=(const Entity& other) const { return id != other.id; };
-    bool operator >(const Entity& other) const { return id > other.id; };
-    bool operator <(const Entity& other) const { return id < other.id; };
+    bool operator ==(const Entity& other) const { return id == other.id && generation == other.generation; };
+    bool operator !=(const Entity& other) const { return !(*this == other); };
+    bool operator >(const Entity& other) const { return other < *this; };
+    bool operator <(const Entity& other) const { return id < other.id || (id == other.id && generation < other.generation); };
 
     template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
     template <typename TComponent> void RemoveComponent();
     template <typename TComponent> bool HasComponent() const;
     template <typename TComponent> TComponent& GetComponent() const;
+    template <typename TComponent> const TComponent& ReadComponent() const;
+    template <typename TComponent, typename ...TArgs> TComponent& ReplaceComponent(TArgs&& ...args);
+    template <typename TComponent, typename TFunc> TComponent& PatchComponent(TFunc&& func);
 
     // Hold a pointer to the entity's owner registry.
-    class Registry* registry;
+    class Registry* registry = nullptr;
+};
+
+// Non-owning view over a contiguous range of entities (e.g. the members of a system).
+class EntityView
+{
+private:
+    const Entity* first;
+    const Entity* last;
+
+public:
+    EntityView(const Entity* first, const Entity* last) : first(first), last(last) {}
+
+    const Entity* begin() const { return first; }
+    const Entity* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    const Entity& operator [](size_t index) const { return first[index]; }
 };
 
 // The system processes entities that contain a specific signature.
@@ -73,19 +271,70 @@ class System
 {
 private:
     Signature component_signature;
+
+    // The enabled members come first, followed by the disabled ones (entities parked for reuse by the registry).
     std::vector<Entity> entities;
+    size_t num_enabled_entities = 0;
+
+    // Components the system reads and writes during its update, used by the
+    // SystemScheduler to decide which systems may run at the same time.
+    Signature read_signature;
+    Signature write_signature;
+    bool is_exclusive = false;
+
+    // Sparse index of the members (entity id -> index in entities, or -1), so removal is a swap-and-pop.
+    std::vector<int> entity_indices;
+
+    void SwapEntities(int index_a, int index_b);
+
+    // Members added or enabled since the last EachNewEntity(), only recorded when the system asks for them.
+    bool is_tracking_new_entities = false;
+    std::vector<Entity> new_entities;
+
+    friend class Registry;
 
 public:
     System() = default;
     ~System() = default;
 
+    // Membership only changes inside Registry::Update(), never while systems are running.
     void AddEntityToSystem(Entity entity);
     void RemoveEntityFromSystem(Entity entity);
-    std::vector<Entity> GetSystemEntities() const;
+    bool HasEntity(Entity entity) const;
+    // Disabled members stay in the system but are left out of GetSystemEntities().
+    // Enabling a member also updates its handle (the registry gives reused entities a new generation).
+    void DisableEntityInSystem(Entity entity);
+    void EnableEntityInSystem(Entity entity);
+
+    // View over the enabled system entities, without copying them.
+    // Creating or killing entities while iterating is safe: the registry defers those
+    // changes until its next Update(), so the view stays valid for the whole system update.
+    EntityView GetSystemEntities() const;
     const Signature& GetComponentSignature() const;
 
     // Define the component type T that entities must have to be considered by the system.
+    // Required components are also declared as read.
     template <typename TComponent> void RequireComponent();
+
+    // Declare the components the system update touches besides its required ones.
+    template <typename TComponent> void ReadsComponent();
+    template <typename TComponent> void WritesComponent();
+
+    // The system never runs alongside another one (e.g. it creates entities or runs Lua scripts).
+    void RequireExclusiveAccess();
+
+    // Record the entities that join the system (or are enabled again), for EachNewEntity().
+    void TrackNewEntities();
+    // Call func(Entity) once for every entity that joined the system or was enabled again since the last call,
+    // and is still an enabled member. Lets a system set up per-entity state without scanning all its entities.
+    template <typename TFunc> void EachNewEntity(TFunc&& func);
+
+    const Signature& GetReadSignature() const;
+    const Signature& GetWriteSignature() const;
+    bool IsExclusive() const;
+
+    // True if the two systems must not run at the same time.
+    bool ConflictsWith(const System& other) const;
 };
 
 class IPool
@@ -93,104 +342,567 @@ class IPool
 public:
     virtual ~IPool() = default;
     virtual void RemoveEntityFromPool(int entity_id) = 0;
+    // Remove the components of count entities that all have one, given sorted by id.
+    virtual void RemoveMany(const int* entity_ids, size_t count) = 0;
 };
 
-// A pool is just a vector (contiguous data) of objects of type T.
+// Number of entity ids covered by one page of a pool's sparse array (must be a power of two).
+const unsigned int POOL_PAGE_SIZE = 4096;
+
+// Size in bytes of the blocks that hold a pool's component data.
+const size_t POOL_BLOCK_SIZE = 16 * 1024;
+
+// Number of components of type T per pool block: the largest power of two that fits in POOL_BLOCK_SIZE.
+template <typename T>
+constexpr size_t GetPoolBlockCapacity() {
+    size_t capacity = 1;
+    while (capacity * 2 * sizeof(T) <= POOL_BLOCK_SIZE) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// A pool is a sparse set of objects of type T.
+// The components are kept packed for iteration, while the paged sparse
+// array maps an entity id straight to its packed index without any hashing.
+// The packed components live in fixed-size blocks that are never moved: growing the pool
+// only adds a block, so references to components stay valid until that component is removed
+// (removal moves the last component into the hole to keep the pool packed).
 template <typename T>
 class Pool : public IPool
 {
 private:
+    static constexpr size_t BLOCK_CAPACITY = GetPoolBlockCapacity<T>();
+
+    // Packed component data in blocks of BLOCK_CAPACITY objects, and the entity id that owns the element at the same index.
+    // Blocks are kept when the pool shrinks, and reused when it grows again.
+    std::vector<T*> blocks;
+    size_t size = 0;
+    std::vector<int> dense_entity_ids;
+
+    // Paged sparse array (entity id -> packed index, or -1 if the entity has no component).
+    // Pages are only allocated for id ranges that are actually used.
+    std::vector<std::unique_ptr<int[]>> sparse_pages;
+
+    int* GetSparseSlot(int entity_id) const {
+        const size_t page = static_cast<size_t>(entity_id) / POOL_PAGE_SIZE;
+        if (page >= sparse_pages.size() || !sparse_pages[page]) {
+            return nullptr;
+        }
+        return &sparse_pages[page][static_cast<size_t>(entity_id) & (POOL_PAGE_SIZE - 1)];
+    }
 
-    // Keep track of the vector of objects and the current number of elements.
-    std::vector<T> data;
-    int size;
-    
-    // Helper maps to keep track of entity IDs per index, so the vector is always packed.
-    std::unordered_map<int, int> entity_id_to_index;
-    std::unordered_map<int, int> index_to_entity_id;
+    int& GetOrCreateSparseSlot(int entity_id) {
+        const size_t page = static_cast<size_t>(entity_id) / POOL_PAGE_SIZE;
+        if (page >= sparse_pages.size()) {
+            sparse_pages.resize(page + 1);
+        }
+        if (!sparse_pages[page]) {
+            sparse_pages[page] = std::make_unique<int[]>(POOL_PAGE_SIZE);
+            std::fill_n(sparse_pages[page].get(), POOL_PAGE_SIZE, -1);
+        }
+        return sparse_pages[page][static_cast<size_t>(entity_id) & (POOL_PAGE_SIZE - 1)];
+    }
+
+    T* GetSlot(size_t index) const {
+        return blocks[index / BLOCK_CAPACITY] + (index & (BLOCK_CAPACITY - 1));
+    }
 
 public:
 
-    Pool(int capacity = 100) {
-        size = 0;
-        data.resize(capacity);
+    Pool(int capacity = 0) {
+        Reserve(capacity);
     }
 
-    virtual ~Pool() = default;
+    virtual ~Pool() {
+        Clear();
+        for (auto block : blocks) {
+            std::allocator<T>().deallocate(block, BLOCK_CAPACITY);
+        }
+    }
+
+    Pool(const Pool&) = delete;
+    Pool& operator =(const Pool&) = delete;
 
     bool IsEmpty() const {
         return size == 0;
     }
 
     int GetSize() const {
-        return size;
+        return static_cast<int>(size);
     }
 
-    void Resize(int n) {
-        data.resize(n);
+    // Allocate the blocks for n components up front.
+    void Reserve(int n) {
+        while (blocks.size() * BLOCK_CAPACITY < static_cast<size_t>(n)) {
+            blocks.push_back(std::allocator<T>().allocate(BLOCK_CAPACITY));
+        }
+        // Emplace() and spawns reserve a few more elements at a time, so the ids still grow geometrically.
+        if (static_cast<size_t>(n) > dense_entity_ids.capacity()) {
+            dense_entity_ids.reserve(std::max(static_cast<size_t>(n), dense_entity_ids.capacity() * 2));
+        }
     }
 
     void Clear() {
-        data.clear();
+        for (size_t i = 0; i < size; i++) {
+            GetSlot(i)->~T();
+        }
         size = 0;
+        dense_entity_ids.clear();
+        sparse_pages.clear();
     }
 
-    void Add(T object) {
-        data.push_back(object);
+    bool Has(int entity_id) const {
+        const int* slot = GetSparseSlot(entity_id);
+        return slot && *slot != -1;
     }
 
-    void Set(int entity_id, T object) {
-        if (entity_id_to_index.find(entity_id) != entity_id_to_index.end()) {
-            // If the element already exists, replace the component object.
-            int index = entity_id_to_index[entity_id];
-            data[index] = object;
-        } else {
-            // When adding a new object, keep track of the entity IDs and their vector indicies.
-            int index = size;
-            entity_id_to_index.emplace(entity_id, index);
-            index_to_entity_id.emplace(index, entity_id);
-            if (index >= data.capacity()) {
-                // If necessary, resize by doubling the current capacity.
-                data.resize(size * 2);
-            }
-            data[index] = object;
-            size++;
+    // Construct the component of the entity straight in the pool from args.
+    // If the entity already has the component, it is replaced.
+    template <typename ...TArgs>
+    T& Emplace(int entity_id, TArgs&& ...args) {
+        int& index = GetOrCreateSparseSlot(entity_id);
+        if (index != -1) {
+            T& object = *GetSlot(index);
+            object = T(std::forward<TArgs>(args)...);
+            return object;
         }
+
+        // When adding a new object, append it to the packed data and remember its index.
+        Reserve(static_cast<int>(size) + 1);
+        T* object = new (GetSlot(size)) T(std::forward<TArgs>(args)...);
+        dense_entity_ids.push_back(entity_id);
+        index = static_cast<int>(size++);
+        return *object;
     }
 
-    void Remove(int entity_id) {
-        // Copy the last element to the deleted position to keep the array packed.
-        int index_of_removed = entity_id_to_index[entity_id];
-        int index_of_last = size - 1;
-        data[index_of_removed] = data[index_of_last];
+    // Replace the existing component of the entity with one constructed from args.
+    template <typename ...TArgs>
+    T& Replace(int entity_id, TArgs&& ...args) {
+        T& object = Get(entity_id);
+        object = T(std::forward<TArgs>(args)...);
+        return object;
+    }
 
-        // Update the index-entity maps to point to the correct elements.
-        int entity_id_of_last_element = index_to_entity_id[index_of_last];
-        entity_id_to_index[entity_id_of_last_element] = index_of_removed;
-        index_to_entity_id[index_of_removed] = entity_id_of_last_element;
+    // Modify the existing component of the entity in place with func(T&).
+    template <typename TFunc>
+    T& Patch(int entity_id, TFunc&& func) {
+        T& object = Get(entity_id);
+        func(object);
+        return object;
+    }
 
-        entity_id_to_index.erase(entity_id);
-        index_to_entity_id.erase(index_of_last);
+    void Set(int entity_id, T object) {
+        Emplace(entity_id, std::move(object));
+    }
 
+    void Remove(int entity_id) {
+        // Move the last element to the deleted position to keep the data packed.
+        int* slot = GetSparseSlot(entity_id);
+        const int index_of_removed = *slot;
+        const int index_of_last = static_cast<int>(size) - 1;
+        const int entity_id_of_last_element = dense_entity_ids[index_of_last];
+
+        if (index_of_removed != index_of_last) {
+            *GetSlot(index_of_removed) = std::move(*GetSlot(index_of_last));
+        }
+        GetSlot(index_of_last)->~T();
         size--;
+
+        dense_entity_ids[index_of_removed] = entity_id_of_last_element;
+        *GetSparseSlot(entity_id_of_last_element) = index_of_removed;
+        *slot = -1;
+
+        dense_entity_ids.pop_back();
     }
 
     void RemoveEntityFromPool(int entity_id) override {
-        if (entity_id_to_index.find(entity_id) != entity_id_to_index.end()) {
+        if (Has(entity_id)) {
             Remove(entity_id);
         }
     }
 
+    void RemoveMany(const int* entity_ids, size_t count) override {
+        for (size_t i = 0; i < count; i++) {
+            Remove(entity_ids[i]);
+        }
+    }
+
     T& Get(int entity_id) {
-        int index = entity_id_to_index[entity_id];
-        return static_cast<T&>(data[index]);
+        return *GetSlot(*GetSparseSlot(entity_id));
+    }
+
+    const T& Read(int entity_id) const {
+        return *GetSlot(*GetSparseSlot(entity_id));
+    }
+
+    // Entity id that owns the packed element at index.
+    int GetEntityId(unsigned int index) const {
+        return dense_entity_ids[index];
+    }
+
+    // Packed entity ids, in the same order as the component data.
+    const std::vector<int>& GetEntityIds() const {
+        return dense_entity_ids;
     }
 
     T& operator [](unsigned int index) {
-        return data[index];
+        return *GetSlot(index);
+    }
+
+    // Call func(T&) for every component in packed order. Walking a block at a time is as fast as
+    // iterating a plain array, while operator[] has to find the block of every index.
+    template <typename TFunc>
+    void Each(TFunc&& func) {
+        for (size_t first = 0; first < size; first += BLOCK_CAPACITY) {
+            T* block = blocks[first / BLOCK_CAPACITY];
+            const size_t count = std::min(BLOCK_CAPACITY, size - first);
+            for (size_t i = 0; i < count; i++) {
+                func(block[i]);
+            }
+        }
+    }
+};
+
+// Change tracking of one component type, kept by the registry beside the storage so it works with both storages.
+// Every entity remembers the tick of the last change of its component. The changes of the past ticks are also
+// logged in tick order, so a reader can find the changes since any earlier tick without scanning all the entities.
+// A log record is stale once its entity changed again, and stale records are dropped when the log grows,
+// so the log never holds much more than one record per entity however far behind a reader is.
+class ComponentChanges
+{
+private:
+    struct Change
+    {
+        uint32_t tick;
+        int entity_id;
+    };
+
+    uint32_t tick = 0;
+    // vector index = entity id, tick of the last change of its component (0 if it never changed).
+    std::vector<uint32_t> versions;
+    // Entities changed during the current tick, recorded per job system thread.
+    PerThread<std::vector<int>> changed_entity_ids;
+    // Changes of the past ticks, sorted by tick and then by entity id.
+    std::vector<Change> changes;
+    std::vector<int> found_entity_ids;
+
+public:
+    ComponentChanges(uint32_t current_tick, unsigned int num_threads);
+
+    void SetNumThreads(unsigned int num_threads) { changed_entity_ids.Resize(num_threads); }
+
+    // Move the changes of the current tick to the log, and start the next tick.
+    void BeginTick(uint32_t current_tick);
+
+    // Record a change of the component of the entity during the current tick.
+    // The entity must already have a version: the component was added with MarkAdded(), or was there when tracking started.
+    // Marking is not synchronized, so two threads must not mark the same entity (which the system scheduler already guarantees).
+    void MarkChanged(int entity_id) {
+        uint32_t& version = versions[entity_id];
+        if (version != tick) {
+            version = tick;
+            changed_entity_ids[JobSystem::GetThreadIndex()].push_back(entity_id);
+        }
+    }
+
+    // Record a component added to the entity. Called from the main thread only, since it may grow the versions.
+    void MarkAdded(int entity_id) {
+        if (static_cast<size_t>(entity_id) >= versions.size()) {
+            versions.resize(std::max(static_cast<size_t>(entity_id) + 1, versions.size() * 2), 0);
+        }
+        MarkChanged(entity_id);
+    }
+
+    uint32_t GetVersion(int entity_id) const {
+        return static_cast<size_t>(entity_id) < versions.size() ? versions[entity_id] : 0;
+    }
+
+    // Ids of the entities whose component changed in a tick after since_tick, sorted.
+    // They may include entities that lost the component since. Valid until the next call.
+    const std::vector<int>& FindChangedEntityIds(uint32_t since_tick);
+};
+
+
+
+// Size in bytes of one archetype chunk.
+const size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+
+// Type-erased operations on a component type, used by the archetype storage to move rows between chunks.
+struct ComponentTypeInfo
+{
+    size_t size;
+    size_t alignment;
+    void (*move_construct)(void* destination, void* source);
+    void (*destroy)(void* object);
+
+    template <typename T>
+    static const ComponentTypeInfo* Get() {
+        static const ComponentTypeInfo info = {
+            sizeof(T),
+            alignof(T),
+            [](void* destination, void* source) { new (destination) T(std::move(*static_cast<T*>(source))); },
+            [](void* object) { static_cast<T*>(object)->~T(); }
+        };
+        return &info;
+    }
+};
+
+// A chunk holds up to chunk_capacity entities of one archetype.
+// Its memory starts with the entity id column, followed by one contiguous column per component type.
+struct ArchetypeChunk
+{
+    std::unique_ptr<std::max_align_t[]> memory;
+    int count = 0;
+};
+
+// An archetype stores all the entities that have exactly the same signature.
+class Archetype
+{
+private:
+    Signature signature;
+    int chunk_capacity;
+    size_t chunk_size;
+
+    // One column per component type of the signature, sorted by component id.
+    std::vector<int> column_component_ids;
+    std::vector<const ComponentTypeInfo*> column_types;
+    std::vector<size_t> column_offsets;
+
+    // Component id -> column index (or -1 if the archetype does not have that component).
+    std::vector<int> column_per_component;
+
+    // Chunks in use come first. Chunks emptied by removals are kept around to be reused.
+    std::vector<ArchetypeChunk> chunks;
+    int num_chunks_in_use = 0;
+
+public:
+    // Cached archetype transitions when a component id is added or removed.
+    std::vector<Archetype*> add_edges;
+    std::vector<Archetype*> remove_edges;
+
+    Archetype(const Signature& signature, const std::vector<const ComponentTypeInfo*>& component_types);
+    ~Archetype();
+
+    const Signature& GetSignature() const { return signature; }
+    int GetNumChunks() const { return num_chunks_in_use; }
+    int GetChunkCapacity() const { return chunk_capacity; }
+    int GetChunkCount(int chunk) const { return chunks[chunk].count; }
+    int GetColumn(int component_id) const { return column_per_component[component_id]; }
+    const std::vector<int>& GetColumnComponentIds() const { return column_component_ids; }
+
+    int* GetEntityIds(int chunk) const {
+        return reinterpret_cast<int*>(chunks[chunk].memory.get());
+    }
+
+    void* GetColumnData(int column, int chunk) const {
+        return reinterpret_cast<unsigned char*>(chunks[chunk].memory.get()) + column_offsets[column];
+    }
+
+    void* GetComponent(int column, int chunk, int row) const {
+        return static_cast<unsigned char*>(GetColumnData(column, chunk)) + row * column_types[column]->size;
+    }
+
+    // Appends an uninitialized row for entity_id and returns its chunk and row.
+    void AllocateRow(int entity_id, int& chunk, int& row);
+
+    // Destroys the components of a row and moves the last row of the archetype into the hole.
+    // Returns the entity id of the moved row, or -1 if the removed row was the last one.
+    int RemoveRow(int chunk, int row);
+};
+
+// Component storage that groups entities by signature into archetype chunks.
+class ArchetypeStorage
+{
+private:
+    struct EntityLocation
+    {
+        Archetype* archetype = nullptr;
+        int chunk = 0;
+        int row = 0;
+    };
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<Signature, Archetype*> archetype_per_signature;
+
+    // Type information of every component id that has been used so far.
+    std::vector<const ComponentTypeInfo*> component_types;
+
+    // vector index = entity id
+    std::vector<EntityLocation> entity_locations;
+
+    Archetype* GetOrCreateArchetype(const Signature& signature);
+
+    // Moves the entity row to the archetype with the given signature (nullptr when the signature is empty).
+    // Components shared by both archetypes are moved, the others are destroyed.
+    void MoveEntity(int entity_id, Archetype* target);
+
+public:
+    ArchetypeStorage() : component_types(MAX_COMPONENTS, nullptr) {}
+
+    void RegisterComponentType(int component_id, const ComponentTypeInfo* type) {
+        component_types[component_id] = type;
+    }
+
+    // Moves the entity to the archetype that also has component_id, and returns the
+    // uninitialized memory where the new component must be constructed.
+    void* AddComponent(int entity_id, int component_id);
+    // Moves count entities without components to the archetype of signature,
+    // and leaves all their components uninitialized.
+    void AddEntities(const Entity* entities, int count, const Signature& signature);
+    void RemoveComponent(int entity_id, int component_id);
+    void RemoveEntity(int entity_id);
+
+    bool HasComponent(int entity_id, int component_id) const {
+        return static_cast<size_t>(entity_id) < entity_locations.size() && entity_locations[entity_id].archetype &&
+            entity_locations[entity_id].archetype->GetSignature().test(component_id);
+    }
+
+    void* GetComponent(int entity_id, int component_id) const {
+        const auto& location = entity_locations[entity_id];
+        return location.archetype->GetComponent(location.archetype->GetColumn(component_id), location.chunk, location.row);
+    }
+
+    const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const {
+        return archetypes;
     }
 };
 
+// Marks the entities that the registry parked for reuse (see Prefab::SetRecyclable()).
+// Systems and views skip them.
+struct DisabledComponent
+{
+};
+
+REGISTER_COMPONENT(DisabledComponent, MAX_REGISTERED_COMPONENTS - 1);
+
+// A prefab is a template for entities: component values, groups, and the signature they add up to.
+// Registry::Spawn() creates entities from it in one batch, with one storage lookup per component type
+// instead of one per component of every entity.
+class Prefab
+{
+private:
+    struct ComponentTemplate
+    {
+        int component_id;
+        const ComponentTypeInfo* type;
+        // Components values are immutable once added, so copies of the prefab can share them.
+        std::shared_ptr<const void> value;
+        // Adds a copy of value to count new entities.
+        void (*spawn)(Registry& registry, const void* value, const Entity* entities, int count);
+        // Assigns value to the existing component of count reused entities.
+        void (*overwrite)(Registry& registry, const void* value, const Entity* entities, int count);
+    };
+
+    Signature signature;
+    uint64_t group_mask = 0;
+    std::vector<ComponentTemplate> components;
+    bool is_recyclable = false;
+
+    // Unique id, so the registry can keep track of the entities of a prefab without holding on to the prefab.
+    int id;
+    static int next_id;
+
+    friend class Registry;
+
+public:
+    Prefab() : id(next_id++) {}
+    // A copy is a new prefab that can change on its own, so it gets its own id. A move keeps the id.
+    Prefab(const Prefab& other);
+    Prefab(Prefab&& other) = default;
+    Prefab& operator =(const Prefab& other);
+    Prefab& operator =(Prefab&& other) = default;
+
+    // Add a component value to the prefab, replacing the one of the same type if any.
+    template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
+    template <typename TComponent> bool HasComponent() const { return signature.test(Component<TComponent>::GetId()); }
+    void Group(GroupId group);
+    void Group(const std::string& group);
+
+    // Killed entities of a recyclable prefab are parked instead of destroyed, and the next spawns of the prefab
+    // reuse them: they keep their storage and system membership, and only get their components overwritten.
+    // Stale handles to a parked entity are invalidated like for a destroyed one.
+    // The registry keeps the parked entities until Registry::ReleasePrefab() or TrimParkedEntities().
+    void SetRecyclable(bool is_recyclable) { this->is_recyclable = is_recyclable; }
+    bool IsRecyclable() const { return is_recyclable; }
+
+    int GetId() const { return id; }
+    const Signature& GetSignature() const { return signature; }
+};
+
+// Size of the memory blocks that command buffers record their component data into.
+const size_t COMMAND_BUFFER_BLOCK_SIZE = 64 * 1024;
+
+// A command buffer records entity changes to apply at the start of the next registry Update().
+// Every job system thread records into its own buffer (Registry::GetCommandBuffer()),
+// so systems running in parallel jobs can create entities and edit components without locking.
+// The command headers and their data are appended linearly and the memory is reused every frame.
+class CommandBuffer
+{
+private:
+    enum CommandType {
+        COMMAND_COMPONENT,
+        COMMAND_TAG,
+        COMMAND_GROUP,
+        COMMAND_KILL
+    };
+
+    struct Command
+    {
+        CommandType type;
+        int component_id;
+        int entity_id;
+        int entity_generation;
+        void (*apply)(Registry& registry, Entity entity, void* data);
+        void (*destroy)(void* data);
+        void* data;
+    };
+
+    struct Block
+    {
+        std::unique_ptr<std::max_align_t[]> memory;
+        size_t size;
+    };
+
+    std::vector<Command> commands;
+    std::vector<Block> blocks;
+    size_t current_block = 0;
+    size_t current_block_offset = 0;
+
+    // Entities created through this buffer, and the prefab they are spawned from (or nullptr).
+    // Until the buffer is applied they are referred to by placeholder ids (-1 for the first one, -2 for the second one...).
+    std::vector<const Prefab*> created_entity_prefabs;
+    std::vector<Entity> created_entities;
+
+    void* Allocate(size_t size, size_t alignment);
+    void Record(CommandType type, int component_id, Entity entity, void (*apply)(Registry&, Entity, void*), void (*destroy)(void*), void* data);
+    Entity ResolveEntity(int entity_id, int entity_generation) const;
+    void Clear();
+
+    friend class Registry;
+
+public:
+    CommandBuffer() = default;
+    CommandBuffer(CommandBuffer&&) = default;
+    ~CommandBuffer();
+
+    bool IsEmpty() const { return commands.empty() && created_entity_prefabs.empty(); }
+
+    // Returns a placeholder handle for a new entity.
+    // The handle can only be passed back to this command buffer; the entity is created in the next registry Update().
+    Entity CreateEntity();
+    // Same as CreateEntity(), for an entity spawned from the prefab (which must outlive the next registry Update()).
+    // Components added to the entity through this buffer replace the ones of the prefab.
+    Entity Spawn(const Prefab& prefab);
+
+    template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+    template <typename TComponent> void RemoveComponent(Entity entity);
+    void TagEntity(Entity entity, TagId tag);
+    void GroupEntity(Entity entity, GroupId group);
+    void KillEntity(Entity entity);
+};
+
+template <typename ...TComponents> class ComponentView;
 
 // Registry
 // The Registry manages the creation and destruction of entities.
@@ -201,37 +913,149 @@ private:
     // Keep track of how many entities were added to the scene.
     int num_entities = 0;
 
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Components of all entities, grouped by signature into chunks.
+    ArchetypeStorage archetype_storage;
+#else
     // Vector of component pools.
     // Each pool contains all the data for a certain component type.
     // vector index = component_id
     // pool index = entity_id
     std::vector<std::shared_ptr<IPool>> component_pools;
 
+    // Ids of the entities killed in the current Update(), per component they own (index = component_id).
+    std::vector<std::vector<int>> killed_entity_ids_per_component;
+#endif
+
     // Vector of component signatures.
     // The signature lets us know which components are turned "on" for an entity.
     // vector index = entity id
     std::vector<Signature> entity_component_signatures;
 
+    // Current generation of every entity id, bumped each time the id is freed.
+    // vector index = entity id
+    std::vector<int> entity_generations;
+
     // Map of active systems (index = system type_id).
     std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
 
-    // Set of entities that are flagged to be added or removed in the next registry Update()
-    std::set<Entity> entities_to_be_added;
-    std::set<Entity> entities_to_be_killed;
+    // Flat table of the active systems and their signatures, so an entity signature
+    // can be matched against every system in a single pass over contiguous memory.
+    std::vector<System*> system_table;
+    std::vector<Signature> system_signatures;
+    void RebuildSystemTable();
+
+    // System membership as bit masks over the system table (bit i = system_table[i]), so a signature
+    // change only visits the systems that care about the changed component.
+    // systems_per_component: vector index = component id, the systems that require the component.
+    // entity_systems: vector index = entity id, the systems the entity belongs to.
+    // entity_systems_to_update: vector index = entity id, the systems whose membership must be checked in the next Update().
+    std::vector<uint64_t> systems_per_component;
+    std::vector<uint64_t> entity_systems;
+    std::vector<uint64_t> entity_systems_to_update;
+    uint64_t all_systems = 0;
+    // Live entities that gained or lost a component since the last Update().
+    std::vector<int> entities_to_be_updated;
+    // Components removed since the last Update(). They leave the storage in the next Update(),
+    // after the entity left the systems that require them, so those systems can still read them until then.
+    struct RemovedComponent
+    {
+        Entity entity;
+        int component_id;
+    };
+    std::vector<RemovedComponent> components_to_be_removed;
+    void MarkEntitySystemsToUpdate(int entity_id, uint64_t system_mask);
+    void UpdateEntitySystems(Entity entity, uint64_t system_mask);
+
+    // Entities that are flagged to be added or removed in the next registry Update().
+    // They are sorted and deduplicated once per update.
+    std::vector<Entity> entities_to_be_added;
+    std::vector<Entity> entities_to_be_killed;
+
+    // One command buffer per job system thread, applied at the start of Update().
+    PerThread<CommandBuffer> command_buffers;
+
+    struct PendingCommand
+    {
+        const CommandBuffer::Command* command;
+        Entity entity;
+        size_t sequence;
+    };
+    std::vector<PendingCommand> pending_commands;
+    void ApplyCommandBuffers();
+
+    // Creates count entities from the prefab and appends them to entities.
+    void SpawnEntities(const Prefab& prefab, int count, std::vector<Entity>& entities);
+    template <typename TComponent> void SpawnComponents(const TComponent& value, const Entity* entities, int count);
+    template <typename TComponent> void OverwriteComponents(const TComponent& value, const Entity* entities, int count);
+    std::vector<Entity> spawned_entities;
+
+    // Entities of every recyclable prefab, by prefab id.
+    struct RecycledEntities
+    {
+        // Signature of the prefab: killed entities whose components changed since they were spawned are destroyed instead.
+        Signature signature;
+        // Ids of the parked entities, waiting to be reused.
+        std::vector<int> parked_entity_ids;
+    };
+    std::unordered_map<int, RecycledEntities> recycled_entities;
+    // Id of the recyclable prefab each entity was spawned from (-1 for the other entities).
+    // vector index = entity id
+    std::vector<int> entity_prefab_ids;
+    // Parked entities reused by a spawn, enabled in their systems at the next Update().
+    std::vector<Entity> entities_to_be_enabled;
+    void ParkEntity(Entity entity);
+    void EnableParkedEntity(Entity entity);
+    // Destroy the parked entities of the prefab past the first num_kept ones, at the next Update().
+    void DestroyParkedEntities(RecycledEntities& prefab_entities, size_t num_kept);
+
+    std::unordered_map<std::string, Prefab> prefabs;
     
-    // Entity tags (one tag name per entity).
-    std::unordered_map<std::string, Entity> entity_per_tag;
-    std::unordered_map<int, std::string> tag_per_entity;
+    // Entity tags (one tag per entity, one entity per tag).
+    // vector index = entity id (-1 if untagged) / tag id (entity id -1 if unused)
+    std::vector<TagId> entity_tags;
+    std::vector<Entity> entity_per_tag;
+
+    // Entity groups: a bit mask of groups per entity, and the packed members of every group.
+    // vector index = entity id / group id
+    struct EntityGroup
+    {
+        std::vector<Entity> entities;
+        // Sparse index of the members (entity id -> index in entities, or -1), so removal is a swap-and-pop.
+        std::vector<int> entity_indices;
+    };
+    std::vector<uint64_t> entity_groups;
+    std::vector<EntityGroup> groups;
+
+    static NameTable& GetTagNames();
+    static NameTable& GetGroupNames();
+
+    // Number of the current update, incremented at the start of every Update().
+    uint32_t tick = 1;
+
+    // vector index = component id, the change tracking of the component type (nullptr if it is not tracked).
+    std::vector<std::unique_ptr<ComponentChanges>> component_changes;
+    ComponentChanges* GetComponentChanges(int component_id) const {
+        return static_cast<size_t>(component_id) < component_changes.size() ? component_changes[component_id].get() : nullptr;
+    }
+
+    // Stack of free entity IDs that were previously removed.
+    // The most recently freed ID is reused first, while its data is still warm in the cache.
+    std::vector<int> free_ids;
 
-    // Entity groups (a set of entities per group name).
-    std::unordered_map<std::string, std::set<Entity>> entities_per_group;
-    std::unordered_map<int, std::string> group_per_entity;
+#ifndef ECS_ARCHETYPE_STORAGE
+    // Returns the pool of TComponent, or nullptr if no entity ever had that component.
+    template <typename TComponent> Pool<TComponent>* GetPool() const;
+    template <typename TComponent> Pool<TComponent>* GetOrCreatePool();
+#endif
 
-    // List of free entity IDs that were previously removed.
-    std::deque<int> free_ids;
+    template <typename ...TComponents> friend class ComponentView;
+    friend class CommandBuffer;
+    friend class Prefab;
 
 public:
-    Registry() {
+    Registry() : systems_per_component(MAX_COMPONENTS, 0) {
+        command_buffers.Resize(1);
         Logger::Log("Registry constructor called.");
     }
     ~Registry() {
@@ -240,28 +1064,98 @@ public:
     void Update();
 
     // Entity management
+    // CreateEntity() and the component functions change the registry immediately and must only be called
+    // from the main thread (or an exclusive system), while KillEntity() is deferred and can be called from any thread.
     Entity CreateEntity();
     void KillEntity(Entity entity);
+    // False for stale handles, and for invalid ones such as the Entity(-1) of GetEntityByTag().
+    bool IsAlive(Entity entity) const {
+        const auto entity_id = entity.GetId();
+        return entity_id >= 0 && static_cast<size_t>(entity_id) < entity_generations.size() && entity_generations[entity_id] == entity.GetGeneration();
+    }
+
+    // Prefabs
+    // Create count entities from the prefab, adding each component type to all of them in one batch,
+    // then call initializer(Entity, int index) on each entity to set its own values.
+    // Like new entities, entities reused from a recyclable prefab only join their systems at the next Update().
+    template <typename TFunc> void Spawn(const Prefab& prefab, int count, TFunc&& initializer);
+    Entity Spawn(const Prefab& prefab);
+    // Prefabs shared by name, e.g. the ones defined by the level script. GetPrefab() returns nullptr for an unknown name.
+    // Adding a prefab under a taken name releases the previous one, RemovePrefabs() releases them all (e.g. when the level is unloaded).
+    void AddPrefab(const std::string& name, Prefab prefab);
+    const Prefab* GetPrefab(const std::string& name) const;
+    void RemovePrefabs();
+    // Destroy the parked entities of a recyclable prefab at the next Update(), when the prefab goes away.
+    // Its live entities are destroyed normally when they are killed.
+    void ReleasePrefab(const Prefab& prefab);
+    // Keep at most max_parked_entities parked entities of the prefab, destroying the others at the next Update().
+    void TrimParkedEntities(const Prefab& prefab, int max_parked_entities);
+
+    // Tag and group names are interned process-wide, so their ids can be resolved once, even before the registry exists.
+    // GetGroupId() returns -1 for the names past the first MAX_GROUPS, logging an error once per name.
+    static TagId GetTagId(const std::string& tag);
+    static GroupId GetGroupId(const std::string& group);
 
     // Tag management
+    // A tag names a single entity: tagging another entity with the same tag moves the tag.
+    void TagEntity(Entity entity, TagId tag);
     void TagEntity(Entity entity, const std::string& tag);
+    // Stale handles have no tag and belong to no group, even when their id was reused.
+    bool EntityHasTag(Entity entity, TagId tag) const { return IsAlive(entity) && entity_tags[entity.GetId()] == tag; }
     bool EntityHasTag(Entity entity, const std::string& tag) const;
+    // Returns an entity with id -1 if no entity has the tag.
+    Entity GetEntityByTag(TagId tag) const;
     Entity GetEntityByTag(const std::string& tag) const;
     void RemoveEntityTag(Entity entity);
 
     // Group management
+    // An entity can belong to several groups. Grouping with an id that is not a valid group (-1) aborts.
+    void GroupEntity(Entity entity, GroupId group);
     void GroupEntity(Entity entity, const std::string& group);
+    bool EntityBelongsToGroup(Entity entity, GroupId group) const { return group >= 0 && IsAlive(entity) && ((entity_groups[entity.GetId()] >> group) & 1); }
     bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
-    std::vector<Entity> GetEntitiesByGroup(const std::string& group) const;
+    // View over the packed members of the group, valid until the group changes.
+    EntityView GetEntitiesByGroup(GroupId group) const;
+    EntityView GetEntitiesByGroup(const std::string& group) const;
     void RemoveEntityGroup(Entity entity);
 
     // Components management
     template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
     template <typename TComponent> void RemoveComponent(Entity entity);
     template <typename TComponent> bool HasComponent(Entity entity) const;
+    // GetComponent() does not count as a change of a tracked component, write with ReplaceComponent() or PatchComponent() instead.
     template <typename TComponent> TComponent& GetComponent(Entity entity) const;
+    template <typename TComponent> const TComponent& ReadComponent(Entity entity) const;
+    // Hint that num_components components of type TComponent are about to be added,
+    // so their storage is allocated once up front.
+    template <typename TComponent> void Reserve(int num_components);
+    // Replace the existing component of the entity with one constructed from args.
+    template <typename TComponent, typename ...TArgs> TComponent& ReplaceComponent(Entity entity, TArgs&& ...args);
+    // Modify the existing component of the entity in place with func(TComponent&).
+    template <typename TComponent, typename TFunc> TComponent& PatchComponent(Entity entity, TFunc&& func);
+
+    // Change tracking
+    // Component types opt in with EnableChangeTracking(): the registry then records the tick of every change
+    // (adding the component, spawning it from a prefab, ReplaceComponent(), PatchComponent() or views that take it by non-const reference).
+    // GetComponent(), ReadComponent() and views that take it by const reference do not count.
+    // Types without change tracking always report a change.
+    uint32_t GetTick() const { return tick; }
+    template <typename TComponent> void EnableChangeTracking();
+    // Whether the component of the entity changed in a tick after since_tick (false if the entity does not have it).
+    template <typename TComponent> bool HasComponentChanged(Entity entity, uint32_t since_tick) const;
+    // Call func(Entity) for every entity that has TComponent and whose TComponent changed in a tick after since_tick, sorted by id.
+    // Changes are only told apart by their tick: a reader that passes GetTick() - 1 as of its previous pass sees every change
+    // since that pass, even if it skipped some updates, and sees again the changes made during the tick of that pass.
+    template <typename TComponent, typename TFunc> void EachChangedEntity(uint32_t since_tick, TFunc&& func);
+    // Same, for the changes during the current tick.
+    template <typename TComponent, typename TFunc> void EachChangedEntity(TFunc&& func);
+
+    // Query all the entities that have every component in TComponents.
+    // Example: registry->View<TransformComponent, RigidBodyComponent>().Each([](Entity entity, auto& transform, auto& rigid_body) {...});
+    template <typename ...TComponents> ComponentView<TComponents...> View();
 
     // System management
+    // There can be up to MAX_SYSTEMS systems. Systems added after entities were created only get the entities created afterwards.
     template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
     template <typename TSystem> void RemoveSystem();
     template <typename TSystem> bool HasSystem() const;
@@ -270,13 +1164,278 @@ public:
     // Add and remove entities from their systems.
     void AddEntityToSystems(Entity entity);
     void RemoveEntityFromSystems(Entity entity);
+
+    // Command buffers
+    // Make sure there is a command buffer for every thread of the job system.
+    void ReserveCommandBuffers(unsigned int num_threads);
+    // Command buffer of the calling job system thread.
+    CommandBuffer& GetCommandBuffer() { return command_buffers[JobSystem::GetThreadIndex()]; }
 };
 
+// A view iterates the entities that have all the requested components, straight from the component storage.
+// func is called either as func(Entity, TComponents&...) or as func(TComponents&...).
+// Components that func takes by const reference (or by value) are read without counting as a change.
+// Components must not be added while iterating (removing components, creating and killing entities is fine,
+// those are deferred until the next registry Update()).
+
+// Whether func can take TComponent as a const reference, in which case a view reads it without marking it changed.
+template <typename TFunc, typename TComponent, typename ...TComponents>
+constexpr bool IsReadOnlyInView() {
+    if constexpr (std::is_invocable_v<TFunc, Entity, TComponents&...>) {
+        return std::is_invocable_v<TFunc, Entity, std::conditional_t<std::is_same_v<TComponents, TComponent>, const TComponents&, TComponents&>...>;
+    } else {
+        return std::is_invocable_v<TFunc, std::conditional_t<std::is_same_v<TComponents, TComponent>, const TComponents&, TComponents&>...>;
+    }
+}
+
+// Position of TComponent in TComponents.
+template <typename TComponent, typename ...TComponents>
+constexpr size_t GetIndexInView() {
+    size_t index = 0;
+    bool is_found = false;
+    ((is_found = is_found || std::is_same_v<TComponents, TComponent>, index += is_found ? 0 : 1), ...);
+    return index;
+}
+
+#ifdef ECS_ARCHETYPE_STORAGE
+// Archetype storage: every chunk of every matching archetype is streamed linearly.
+template <typename ...TComponents>
+class ComponentView
+{
+private:
+    Registry* registry;
+    Signature signature;
+    // Change tracking of every component (nullptr if it is not tracked).
+    ComponentChanges* changes[sizeof...(TComponents)];
+
+    // Record the change of the components of a chunk that func takes by non-const reference.
+    template <typename TFunc, typename TComponent>
+    void MarkChanged(const int* entity_ids, int count) {
+        if constexpr (!IsReadOnlyInView<TFunc, TComponent, TComponents...>()) {
+            if (ComponentChanges* component_changes = changes[GetIndexInView<TComponent, TComponents...>()]) {
+                for (int row = 0; row < count; row++) {
+                    component_changes->MarkChanged(entity_ids[row]);
+                }
+            }
+        }
+    }
+
+    // Disabled entities live in their own archetypes, which views skip.
+    bool Matches(const Archetype& archetype) const {
+        return archetype.GetSignature().Contains(signature) && !archetype.GetSignature().test(Component<DisabledComponent>::GetId());
+    }
+
+public:
+    ComponentView(Registry* registry) : registry(registry), changes{registry->GetComponentChanges(Component<TComponents>::GetId())...} {
+        (signature.set(Component<TComponents>::GetId()), ...);
+    }
+
+    // Number of work items that EachInRange() splits over, i.e. the chunks of the matching archetypes.
+    size_t GetRangeSize() const {
+        size_t num_chunks = 0;
+        for (const auto& archetype : registry->archetype_storage.GetArchetypes()) {
+            if (Matches(*archetype)) {
+                num_chunks += archetype->GetNumChunks();
+            }
+        }
+        return num_chunks;
+    }
+
+    // Number of work items of GetRangeSize() that hold about num_entities entities.
+    size_t GetRangeSizeFor(size_t num_entities) const {
+        for (const auto& archetype : registry->archetype_storage.GetArchetypes()) {
+            if (Matches(*archetype)) {
+                return std::max<size_t>(num_entities / archetype->GetChunkCapacity(), 1);
+            }
+        }
+        return 1;
+    }
+
+    // Call func for every entity stored in the matching chunks with index in [begin, end).
+    template <typename TFunc>
+    void EachInRange(size_t begin, size_t end, TFunc&& func) {
+        size_t chunk_index = 0;
+        for (const auto& archetype : registry->archetype_storage.GetArchetypes()) {
+            if (!Matches(*archetype)) {
+                continue;
+            }
+            for (int chunk = 0; chunk < archetype->GetNumChunks(); chunk++, chunk_index++) {
+                if (chunk_index < begin) {
+                    continue;
+                }
+                if (chunk_index >= end) {
+                    return;
+                }
+                const int* entity_ids = archetype->GetEntityIds(chunk);
+                const int count = archetype->GetChunkCount(chunk);
+                std::tuple<TComponents*...> columns(
+                    static_cast<TComponents*>(archetype->GetColumnData(archetype->GetColumn(Component<TComponents>::GetId()), chunk))...
+                );
+                // The changes are recorded for the whole chunk up front, so the loop over the rows stays free of them.
+                (MarkChanged<TFunc, TComponents>(entity_ids, count), ...);
+                for (int row = 0; row < count; row++) {
+                    if constexpr (std::is_invocable_v<TFunc, Entity, TComponents&...>) {
+                        Entity entity(entity_ids[row], registry->entity_generations[entity_ids[row]]);
+                        entity.registry = registry;
+                        func(entity, std::get<TComponents*>(columns)[row]...);
+                    } else {
+                        func(std::get<TComponents*>(columns)[row]...);
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename TFunc>
+    void Each(TFunc&& func) {
+        EachInRange(0, GetRangeSize(), std::forward<TFunc>(func));
+    }
+};
+#else
+// Pool storage: iteration is driven by the smallest of the pools, and every candidate is checked against the signature.
+template <typename ...TComponents>
+class ComponentView
+{
+private:
+    Registry* registry;
+    std::tuple<Pool<TComponents>*...> pools;
+    Signature signature;
+
+    // Change tracking of every component (nullptr if it is not tracked).
+    ComponentChanges* changes[sizeof...(TComponents)];
+
+    // Packed entity ids of the smallest pool (nullptr when one of the pools does not exist yet),
+    // and the position of its component in TComponents.
+    const std::vector<int>* driver_entity_ids = nullptr;
+    size_t driver_component_index = 0;
+
+    // Whether func writes a component that is change tracked.
+    template <typename TFunc>
+    bool IsMarkingChanges() const {
+        return ((!IsReadOnlyInView<TFunc, TComponents, TComponents...>() && changes[GetIndexInView<TComponents, TComponents...>()]) || ...);
+    }
+
+    // The component of the entity at packed index driver_index of the driving pool.
+    template <bool IS_MARKING_CHANGES, typename TFunc, typename TComponent>
+    decltype(auto) GetComponent(int entity_id, size_t driver_index) {
+        constexpr size_t component_index = GetIndexInView<TComponent, TComponents...>();
+        Pool<TComponent>* pool = std::get<Pool<TComponent>*>(pools);
+        // The driving pool has the component at the index being iterated, only the other pools need a sparse lookup.
+        TComponent& component = component_index == driver_component_index ? (*pool)[static_cast<unsigned int>(driver_index)] : pool->Get(entity_id);
+        if constexpr (IsReadOnlyInView<TFunc, TComponent, TComponents...>()) {
+            return static_cast<const TComponent&>(component);
+        } else {
+            if constexpr (IS_MARKING_CHANGES) {
+                if (ComponentChanges* component_changes = changes[component_index]) {
+                    component_changes->MarkChanged(entity_id);
+                }
+            }
+            return component;
+        }
+    }
+
+    template <bool IS_MARKING_CHANGES, typename TFunc>
+    void EachInRange(size_t begin, size_t end, TFunc& func) {
+        const auto& entity_ids = *driver_entity_ids;
+        const auto& entity_component_signatures = registry->entity_component_signatures;
+        for (size_t i = begin; i < end; i++) {
+            const int entity_id = entity_ids[i];
+            const auto& entity_component_signature = entity_component_signatures[entity_id];
+            if (!entity_component_signature.Contains(signature) || entity_component_signature.test(Component<DisabledComponent>::GetId())) {
+                continue;
+            }
+            if constexpr (std::is_invocable_v<TFunc, Entity, TComponents&...>) {
+                Entity entity(entity_id, registry->entity_generations[entity_id]);
+                entity.registry = registry;
+                func(entity, GetComponent<IS_MARKING_CHANGES, TFunc, TComponents>(entity_id, i)...);
+            } else {
+                func(GetComponent<IS_MARKING_CHANGES, TFunc, TComponents>(entity_id, i)...);
+            }
+        }
+    }
+
+public:
+    ComponentView(Registry* registry)
+        : registry(registry), pools(registry->GetPool<TComponents>()...), changes{registry->GetComponentChanges(Component<TComponents>::GetId())...} {
+        (signature.set(Component<TComponents>::GetId()), ...);
+
+        const bool has_all_pools = ((std::get<Pool<TComponents>*>(pools) != nullptr) && ...);
+        if (!has_all_pools) {
+            return;
+        }
+
+        // Drive the iteration from the smallest pool.
+        auto consider_pool = [this](const auto* pool, size_t component_index) {
+            if (!driver_entity_ids || pool->GetEntityIds().size() < driver_entity_ids->size()) {
+                driver_entity_ids = &pool->GetEntityIds();
+                driver_component_index = component_index;
+            }
+        };
+        (consider_pool(std::get<Pool<TComponents>*>(pools), GetIndexInView<TComponents, TComponents...>()), ...);
+    }
+
+    // Number of work items that EachInRange() splits over, i.e. the size of the smallest pool.
+    size_t GetRangeSize() const {
+        return driver_entity_ids ? driver_entity_ids->size() : 0;
+    }
+
+    // Number of work items of GetRangeSize() that hold about num_entities entities.
+    size_t GetRangeSizeFor(size_t num_entities) const {
+        return std::max<size_t>(num_entities, 1);
+    }
+
+    // Call func for every matching entity with index in [begin, end) of the driving pool.
+    template <typename TFunc>
+    void EachInRange(size_t begin, size_t end, TFunc&& func) {
+        if (!driver_entity_ids) {
+            return;
+        }
+        // Whether to mark changes is decided once per range, so the loop over untracked components has no marking at all.
+        if (IsMarkingChanges<std::decay_t<TFunc>>()) {
+            EachInRange<true>(begin, end, func);
+        } else {
+            EachInRange<false>(begin, end, func);
+        }
+    }
+
+    template <typename TFunc>
+    void Each(TFunc&& func) {
+        EachInRange(0, GetRangeSize(), std::forward<TFunc>(func));
+    }
+};
+#endif
 
 template <typename TComponent>
 void System::RequireComponent() {
     const auto component_id = Component<TComponent>::GetId();
     component_signature.set(component_id);
+    read_signature.set(component_id);
+}
+
+template <typename TComponent>
+void System::ReadsComponent() {
+    read_signature.set(Component<TComponent>::GetId());
+}
+
+template <typename TComponent>
+void System::WritesComponent() {
+    write_signature.set(Component<TComponent>::GetId());
+}
+
+template <typename TFunc>
+void System::EachNewEntity(TFunc&& func) {
+    // An entity that left and joined again is recorded twice.
+    std::sort(new_entities.begin(), new_entities.end());
+    new_entities.erase(std::unique(new_entities.begin(), new_entities.end()), new_entities.end());
+    for (auto entity : new_entities) {
+        const auto entity_id = entity.GetId();
+        // Skip the entities that left, were disabled or were reused since.
+        if (!HasEntity(entity) || static_cast<size_t>(entity_indices[entity_id]) >= num_enabled_entities || entities[entity_indices[entity_id]] != entity) {
+            continue;
+        }
+        func(entities[entity_indices[entity_id]]);
+    }
+    new_entities.clear();
 }
 
 
@@ -285,35 +1444,42 @@ void Registry::AddComponent(Entity entity, TArgs && ...args) {
     const auto component_id = Component<TComponent>::GetId();
     const auto entity_id = entity.GetId();
 
-    // If the component_id is greater than the current size of the component_pools, then resize the vector.
-    if (component_id >= component_pools.size()) {
-        component_pools.resize(component_id + 1, nullptr);
-    }
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Create the component before moving the entity, the arguments may refer to components that are about to move.
+    TComponent new_component(std::forward<TArgs>(args)...);
 
-    // If we do not have a Pool for a component type, create a new Pool of type TComponent.
-    if (!component_pools[component_id]) {
-        //Pool<TComponent>* new_component_pool = new Pool<TComponent>();
-        std::shared_ptr<Pool<TComponent>> new_component_pool = std::make_shared<Pool<TComponent>>();
-        component_pools[component_id] = new_component_pool;
+    if (archetype_storage.HasComponent(entity_id, component_id)) {
+        // If the entity already has the component (or it is still stored after a removal), replace the component object.
+        *static_cast<TComponent*>(archetype_storage.GetComponent(entity_id, component_id)) = std::move(new_component);
+    } else {
+        // Move the entity to the archetype that includes the new component.
+        archetype_storage.RegisterComponentType(component_id, ComponentTypeInfo::Get<TComponent>());
+        new (archetype_storage.AddComponent(entity_id, component_id)) TComponent(std::move(new_component));
     }
-
+#else
     // Get the pool of component values for that component type.
-    //Pool<TComponent>* component_pool = Pool<TComponent>(component_pools[component_id]);
-    std::shared_ptr<Pool<TComponent>> component_pool = std::static_pointer_cast<Pool<TComponent>>(component_pools[component_id]);
+    Pool<TComponent>* component_pool = GetOrCreatePool<TComponent>();
 
     // If the entity_id is greater than the current size of the component pool, then resize the pool.
     //if (entity_id >= component_pool->GetSize()) {
     //    component_pool->Resize(num_entities);
     //}
 
-    // Create a new Component object of the type TComponent, and forwarrd the various parameters to the constructor.
-    TComponent new_component(std::forward<TArgs>(args)...);
+    // Construct the component straight in the pool, forwarding the various parameters to the constructor.
+    component_pool->Emplace(entity_id, std::forward<TArgs>(args)...);
+#endif
 
-    // Add the new component to the component_pool list, using the entity_id as index.
-    component_pool->Set(entity_id, new_component);
+    if (ComponentChanges* changes = GetComponentChanges(component_id)) {
+        changes->MarkAdded(entity_id);
+    }
 
     // Finally, change the component signature of the entity and set the component_id on.
-    entity_component_signatures[entity_id].set(component_id);
+    // The systems that require the new component are matched against the entity in the next Update().
+    auto& entity_component_signature = entity_component_signatures[entity_id];
+    if (!entity_component_signature.test(component_id)) {
+        entity_component_signature.set(component_id);
+        MarkEntitySystemsToUpdate(entity_id, systems_per_component[component_id]);
+    }
 
     //Logger::Log("component_id = " + std::to_string(component_id) + " was added to entity_id " + std::to_string(entity_id));
 
@@ -322,16 +1488,21 @@ void Registry::AddComponent(Entity entity, TArgs && ...args) {
 
 template<typename TComponent>
 void Registry::RemoveComponent(Entity entity) {
+    if (!HasComponent<TComponent>(entity)) {
+        return;
+    }
     const auto component_id = Component<TComponent>::GetId();
     const auto entity_id = entity.GetId();
-    
-    // Remove the component from the component list for that entity.
-    std::shared_ptr<Pool<TComponent>> component_pool = std::static_pointer_cast<Pool<TComponent>>(component_pools[component_id]);
-    component_pool->Remove(entity_id);
 
-    // Set this component signature for that entity to false.
+    // Set this component signature for that entity to false: HasComponent() and the pool views no longer see it.
     entity_component_signatures[entity_id].set(component_id, false);
 
+    // Like adding a component, the entity leaves the systems that require it in the next Update(),
+    // so the system entity lists never change while systems iterate them. The component data stays
+    // in the storage until then, for the systems that still hold the entity.
+    MarkEntitySystemsToUpdate(entity_id, systems_per_component[component_id]);
+    components_to_be_removed.push_back({entity, component_id});
+
     //Logger::Log("component_id = " + std::to_string(component_id) + " was removed from entity_id " + std::to_string(entity_id));
 }
 
@@ -345,10 +1516,217 @@ inline bool Registry::HasComponent(Entity entity) const {
 
 template<typename TComponent>
 inline TComponent& Registry::GetComponent(Entity entity) const {
+#ifdef ECS_ARCHETYPE_STORAGE
+    return *static_cast<TComponent*>(archetype_storage.GetComponent(entity.GetId(), Component<TComponent>::GetId()));
+#else
+    return GetPool<TComponent>()->Get(entity.GetId());
+#endif
+}
+
+template<typename TComponent>
+inline const TComponent& Registry::ReadComponent(Entity entity) const {
+#ifdef ECS_ARCHETYPE_STORAGE
+    return GetComponent<TComponent>(entity);
+#else
+    return GetPool<TComponent>()->Read(entity.GetId());
+#endif
+}
+
+template<typename TComponent, typename ...TArgs>
+inline TComponent& Registry::ReplaceComponent(Entity entity, TArgs && ...args) {
+    if (ComponentChanges* changes = GetComponentChanges(Component<TComponent>::GetId())) {
+        changes->MarkChanged(entity.GetId());
+    }
+#ifdef ECS_ARCHETYPE_STORAGE
+    TComponent& component = GetComponent<TComponent>(entity);
+    component = TComponent(std::forward<TArgs>(args)...);
+    return component;
+#else
+    return GetPool<TComponent>()->Replace(entity.GetId(), std::forward<TArgs>(args)...);
+#endif
+}
+
+template<typename TComponent, typename TFunc>
+inline TComponent& Registry::PatchComponent(Entity entity, TFunc&& func) {
+    if (ComponentChanges* changes = GetComponentChanges(Component<TComponent>::GetId())) {
+        changes->MarkChanged(entity.GetId());
+    }
+#ifdef ECS_ARCHETYPE_STORAGE
+    TComponent& component = GetComponent<TComponent>(entity);
+    func(component);
+    return component;
+#else
+    return GetPool<TComponent>()->Patch(entity.GetId(), std::forward<TFunc>(func));
+#endif
+}
+
+#ifndef ECS_ARCHETYPE_STORAGE
+template<typename TComponent>
+inline Pool<TComponent>* Registry::GetPool() const {
     const auto component_id = Component<TComponent>::GetId();
-    const auto entity_id = entity.GetId();
-    auto component_pool = std::static_pointer_cast<Pool<TComponent>>(component_pools[component_id]);
-    return component_pool->Get(entity_id);
+    if (static_cast<size_t>(component_id) >= component_pools.size()) {
+        return nullptr;
+    }
+    return static_cast<Pool<TComponent>*>(component_pools[component_id].get());
+}
+
+template<typename TComponent>
+inline Pool<TComponent>* Registry::GetOrCreatePool() {
+    const auto component_id = Component<TComponent>::GetId();
+
+    // If the component_id is greater than the current size of the component_pools, then resize the vector.
+    if (static_cast<size_t>(component_id) >= component_pools.size()) {
+        component_pools.resize(component_id + 1, nullptr);
+    }
+
+    // If we do not have a Pool for a component type, create a new Pool of type TComponent.
+    if (!component_pools[component_id]) {
+        component_pools[component_id] = std::make_shared<Pool<TComponent>>();
+    }
+    return static_cast<Pool<TComponent>*>(component_pools[component_id].get());
+}
+#endif
+
+template<typename TComponent>
+inline void Registry::Reserve(int num_components) {
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Archetype chunks are allocated per signature, there is nothing to size for a single component type.
+    (void)num_components;
+#else
+    GetOrCreatePool<TComponent>()->Reserve(num_components);
+#endif
+}
+
+template<typename TComponent>
+inline void Registry::EnableChangeTracking() {
+    const auto component_id = Component<TComponent>::GetId();
+    if (GetComponentChanges(component_id)) {
+        return;
+    }
+    if (static_cast<size_t>(component_id) >= component_changes.size()) {
+        component_changes.resize(component_id + 1);
+    }
+    component_changes[component_id] = std::make_unique<ComponentChanges>(tick, command_buffers.GetSize());
+
+    // The components that are already there count as changed now.
+    ComponentChanges& changes = *component_changes[component_id];
+    for (int entity_id = 0; entity_id < static_cast<int>(entity_component_signatures.size()); entity_id++) {
+        if (entity_component_signatures[entity_id].test(component_id)) {
+            changes.MarkAdded(entity_id);
+        }
+    }
+}
+
+template<typename TComponent>
+inline bool Registry::HasComponentChanged(Entity entity, uint32_t since_tick) const {
+    if (!HasComponent<TComponent>(entity)) {
+        return false;
+    }
+    const ComponentChanges* changes = GetComponentChanges(Component<TComponent>::GetId());
+    return !changes || changes->GetVersion(entity.GetId()) > since_tick;
+}
+
+template<typename TComponent, typename TFunc>
+inline void Registry::EachChangedEntity(uint32_t since_tick, TFunc&& func) {
+    const auto component_id = Component<TComponent>::GetId();
+    ComponentChanges* changes = GetComponentChanges(component_id);
+    if (!changes) {
+        View<TComponent>().Each([&func](Entity entity, const TComponent&) {
+            func(entity);
+        });
+        return;
+    }
+    for (auto entity_id : changes->FindChangedEntityIds(since_tick)) {
+        // Skip the entities that lost the component since.
+        if (!entity_component_signatures[entity_id].test(component_id)) {
+            continue;
+        }
+        Entity entity(entity_id, entity_generations[entity_id]);
+        entity.registry = this;
+        func(entity);
+    }
+}
+
+template<typename TComponent, typename TFunc>
+inline void Registry::EachChangedEntity(TFunc&& func) {
+    EachChangedEntity<TComponent>(tick - 1, std::forward<TFunc>(func));
+}
+
+template<typename TFunc>
+inline void Registry::Spawn(const Prefab& prefab, int count, TFunc&& initializer) {
+    // The initializer may spawn entities too, so the new entities are found by index rather than by reference.
+    const size_t first = spawned_entities.size();
+    SpawnEntities(prefab, count, spawned_entities);
+    for (int i = 0; i < count; i++) {
+        initializer(spawned_entities[first + i], i);
+    }
+    spawned_entities.resize(first, Entity(-1));
+}
+
+template<typename TComponent>
+inline void Registry::SpawnComponents(const TComponent& value, const Entity* entities, int count) {
+#ifdef ECS_ARCHETYPE_STORAGE
+    const auto component_id = Component<TComponent>::GetId();
+    for (int i = 0; i < count; i++) {
+        new (archetype_storage.GetComponent(entities[i].GetId(), component_id)) TComponent(value);
+    }
+#else
+    Pool<TComponent>* component_pool = GetOrCreatePool<TComponent>();
+    component_pool->Reserve(component_pool->GetSize() + count);
+    for (int i = 0; i < count; i++) {
+        component_pool->Emplace(entities[i].GetId(), value);
+    }
+#endif
+    if (ComponentChanges* changes = GetComponentChanges(Component<TComponent>::GetId())) {
+        for (int i = 0; i < count; i++) {
+            changes->MarkAdded(entities[i].GetId());
+        }
+    }
+}
+
+template<typename TComponent>
+inline void Registry::OverwriteComponents(const TComponent& value, const Entity* entities, int count) {
+    for (int i = 0; i < count; i++) {
+        GetComponent<TComponent>(entities[i]) = value;
+    }
+    if (ComponentChanges* changes = GetComponentChanges(Component<TComponent>::GetId())) {
+        for (int i = 0; i < count; i++) {
+            changes->MarkChanged(entities[i].GetId());
+        }
+    }
+}
+
+template<typename TComponent, typename ...TArgs>
+inline void Prefab::AddComponent(TArgs && ...args) {
+    const auto component_id = Component<TComponent>::GetId();
+    ComponentTemplate component = {
+        component_id,
+        ComponentTypeInfo::Get<TComponent>(),
+        std::make_shared<const TComponent>(std::forward<TArgs>(args)...),
+        [](Registry& registry, const void* value, const Entity* entities, int count) {
+            registry.SpawnComponents<TComponent>(*static_cast<const TComponent*>(value), entities, count);
+        },
+        [](Registry& registry, const void* value, const Entity* entities, int count) {
+            registry.OverwriteComponents<TComponent>(*static_cast<const TComponent*>(value), entities, count);
+        }
+    };
+
+    if (signature.test(component_id)) {
+        for (auto& existing_component : components) {
+            if (existing_component.component_id == component_id) {
+                existing_component = std::move(component);
+                break;
+            }
+        }
+        return;
+    }
+    signature.set(component_id);
+    components.push_back(std::move(component));
+}
+
+template<typename ...TComponents>
+inline ComponentView<TComponents...> Registry::View() {
+    return ComponentView<TComponents...>(this);
 }
 
 template<typename TSystem, typename ...TArgs>
@@ -356,12 +1734,14 @@ inline void Registry::AddSystem(TArgs && ...args) {
     // TSystem* new_system(new TSystem(std::forward<TArgs>(args)...));
     std::shared_ptr<TSystem> new_system = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
     systems.insert(std::make_pair(std::type_index(typeid(TSystem)), new_system));
+    RebuildSystemTable();
 }
 
 template<typename TSystem>
 inline void Registry::RemoveSystem() {
     auto system = systems.find(std::type_index(typeid(TSystem)));
     systems.erase(system);
+    RebuildSystemTable();
 }
 
 template<typename TSystem>
@@ -375,6 +1755,32 @@ inline TSystem& Registry::GetSystem() const {
     return *(std::static_pointer_cast<TSystem>(system->second));
 }
 
+template <typename TComponent, typename ...TArgs>
+void CommandBuffer::AddComponent(Entity entity, TArgs&& ...args) {
+    static_assert(alignof(TComponent) <= alignof(std::max_align_t), "Over-aligned components cannot be recorded in a command buffer.");
+    void* data = Allocate(sizeof(TComponent), alignof(TComponent));
+    new (data) TComponent(std::forward<TArgs>(args)...);
+    Record(COMMAND_COMPONENT, Component<TComponent>::GetId(), entity,
+        [](Registry& registry, Entity entity, void* data) {
+            registry.AddComponent<TComponent>(entity, std::move(*static_cast<TComponent*>(data)));
+        },
+        [](void* data) {
+            static_cast<TComponent*>(data)->~TComponent();
+        },
+        data);
+}
+
+template <typename TComponent>
+void CommandBuffer::RemoveComponent(Entity entity) {
+    Record(COMMAND_COMPONENT, Component<TComponent>::GetId(), entity,
+        [](Registry& registry, Entity entity, void*) {
+            if (registry.HasComponent<TComponent>(entity)) {
+                registry.RemoveComponent<TComponent>(entity);
+            }
+        },
+        nullptr, nullptr);
+}
+
 template<typename TComponent, typename ...TArgs>
 inline void Entity::AddComponent(TArgs && ...args) {
     registry->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
@@ -394,3 +1800,18 @@ template<typename TComponent>
 inline TComponent& Entity::GetComponent() const {
     return registry->GetComponent<TComponent>(*this);
 }
+
+template<typename TComponent>
+inline const TComponent& Entity::ReadComponent() const {
+    return registry->ReadComponent<TComponent>(*this);
+}
+
+template<typename TComponent, typename ...TArgs>
+inline TComponent& Entity::ReplaceComponent(TArgs && ...args) {
+    return registry->ReplaceComponent<TComponent>(*this, std::forward<TArgs>(args)...);
+}
+
+template<typename TComponent, typename TFunc>
+inline TComponent& Entity::PatchComponent(TFunc&& func) {
+    return registry->PatchComponent<TComponent>(*this, std::forward<TFunc>(func));
+}
@@ -0,0 +1,57 @@
+#include "SystemScheduler.h"
+
+void SystemScheduler::Schedule(const System& system, std::function<void()> update) {
+    scheduled_systems.push_back({ &system, std::move(update), {}, 0 });
+}
+
+void SystemScheduler::BuildDependencies() {
+    for (size_t i = 0; i < scheduled_systems.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (scheduled_systems[i].system->ConflictsWith(*scheduled_systems[j].system)) {
+                scheduled_systems[j].dependents.push_back(i);
+                scheduled_systems[i].num_dependencies++;
+            }
+        }
+    }
+
+    if (num_pending_capacity < scheduled_systems.size()) {
+        num_pending_capacity = scheduled_systems.size();
+        num_pending_dependencies = std::make_unique<std::atomic<int>[]>(num_pending_capacity);
+    }
+    for (size_t i = 0; i < scheduled_systems.size(); i++) {
+        num_pending_dependencies[i].store(scheduled_systems[i].num_dependencies, std::memory_order_relaxed);
+    }
+}
+
+void SystemScheduler::RunSystem(size_t index, JobSystem& job_system, JobCounter& counter) {
+    scheduled_systems[index].update();
+
+    // Release the systems that were only waiting for this one.
+    for (auto dependent : scheduled_systems[index].dependents) {
+        if (num_pending_dependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            job_system.Submit([this, dependent, &job_system, &counter]() { RunSystem(dependent, job_system, counter); }, counter);
+        }
+    }
+}
+
+void SystemScheduler::Run(JobSystem& job_system) {
+    if (is_single_threaded || job_system.GetNumThreads() == 1) {
+        for (auto& scheduled_system : scheduled_systems) {
+            scheduled_system.update();
+        }
+        scheduled_systems.clear();
+        return;
+    }
+
+    BuildDependencies();
+
+    JobCounter counter;
+    for (size_t i = 0; i < scheduled_systems.size(); i++) {
+        if (scheduled_systems[i].num_dependencies == 0) {
+            job_system.Submit([this, i, &job_system, &counter]() { RunSystem(i, job_system, counter); }, counter);
+        }
+    }
+    job_system.Wait(counter);
+
+    scheduled_systems.clear();
+}
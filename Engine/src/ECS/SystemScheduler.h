@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "ECS.h"
+#include "../JobSystem/JobSystem.h"
+
+// Runs the system updates of a frame on the job system.
+// Systems are scheduled in declaration order; a system waits for every system scheduled before it
+// that conflicts with its component accesses (see System::ConflictsWith), so the result is the same
+// as running them one after the other, while independent systems run at the same time.
+class SystemScheduler
+{
+private:
+    struct ScheduledSystem
+    {
+        const System* system;
+        std::function<void()> update;
+        std::vector<size_t> dependents;
+        int num_dependencies;
+    };
+
+    std::vector<ScheduledSystem> scheduled_systems;
+    std::unique_ptr<std::atomic<int>[]> num_pending_dependencies;
+    size_t num_pending_capacity = 0;
+    bool is_single_threaded = false;
+
+    void BuildDependencies();
+    void RunSystem(size_t index, JobSystem& job_system, JobCounter& counter);
+
+public:
+    // Add a system update to the current frame.
+    void Schedule(const System& system, std::function<void()> update);
+
+    // Run every scheduled update and wait for them to finish, then clear the schedule.
+    void Run(JobSystem& job_system);
+
+    // Run the updates one after the other in declaration order on the calling thread (for debugging).
+    void SetSingleThreaded(bool single_threaded) { is_single_threaded = single_threaded; }
+    bool IsSingleThreaded() const { return is_single_threaded; }
+};
@@ -56,12 +56,18 @@ Game::Game() {
     registry = std::make_unique<Registry>();
     asset_store = std::make_unique<AssetStore>();
     event_bus = std::make_unique<EventBus>();
+
+    // One worker per extra hardware thread, the main thread takes part in the jobs too.
+    const unsigned int num_hardware_threads = std::thread::hardware_concurrency();
+    job_system = std::make_unique<JobSystem>(num_hardware_threads > 1 ? num_hardware_threads - 1 : 0);
+    registry->ReserveCommandBuffers(job_system->GetNumThreads());
     Logger::Log("Game constructor called.");
 }
 
 Game::~Game() {
     Logger::Log("Game destructor called.");
-    //for (auto it = begin(Logger::messages); it != end(Logger::messages); ++it) {
+    //const std::vector<LogEntry> messages = Logger::GetMessages();
+    //for (auto it = begin(messages); it != end(messages); ++it) {
     //    std::cout << it->message << std::endl;
     //}
 }
@@ -163,6 +169,13 @@ void Game::ProcessInput() {
                 if (sdl_event.key.keysym.sym == SDLK_d) {
                     is_debug = !is_debug;
                 }
+                if (sdl_event.key.keysym.sym == SDLK_t) {
+                    system_scheduler.SetSingleThreaded(!system_scheduler.IsSingleThreaded());
+                    Logger::Log(system_scheduler.IsSingleThreaded() ? "Systems run on a single thread." : "Systems run on the job system.");
+                }
+                if (sdl_event.key.keysym.sym == SDLK_b) {
+                    registry->GetSystem<CollisionSystem>().ToggleBroadphaseRecording();
+                }
                 event_bus->EmitEvent<KeyPressedEvent>(sdl_event, registry);
                 break;
         }
@@ -187,6 +200,9 @@ void Game::Setup() {
     registry->AddSystem<RenderGUISystem>();
     registry->AddSystem<ScriptSystem>();
 
+    // The health texts are only rebuilt when the health changes.
+    registry->EnableChangeTracking<HealthComponent>();
+
     // Create bindings between C++ and Lua.
     registry->GetSystem<ScriptSystem>().CreateLuaBindings(lua);
 
@@ -223,13 +239,27 @@ void Game::Update() {
     registry->Update();
 
     // Invoke all the systems that need to update.
-    registry->GetSystem<MovementSystem>().Update(delta_time);
-    registry->GetSystem<AnimationSystem>().Update();
-    registry->GetSystem<CollisionSystem>().Update(event_bus);
-    registry->GetSystem<ProjectileEmitSystem>().Update(registry);
-    registry->GetSystem<CameraMovementSystem>().Update(camera);
-    registry->GetSystem<ProjectileLifecycleSystem>().Update();
-    registry->GetSystem<ScriptSystem>().Update(delta_time, SDL_GetTicks());
+    // The scheduler keeps this order between systems that touch the same components,
+    // and runs the others at the same time on the job system.
+    auto& movement_system = registry->GetSystem<MovementSystem>();
+    auto& animation_system = registry->GetSystem<AnimationSystem>();
+    auto& projectile_lifecycle_system = registry->GetSystem<ProjectileLifecycleSystem>();
+    auto& collision_system = registry->GetSystem<CollisionSystem>();
+    auto& projectile_emit_system = registry->GetSystem<ProjectileEmitSystem>();
+    auto& camera_movement_system = registry->GetSystem<CameraMovementSystem>();
+    auto& script_system = registry->GetSystem<ScriptSystem>();
+
+    system_scheduler.Schedule(movement_system, [&]() { movement_system.Update(registry, job_system, delta_time); });
+    system_scheduler.Schedule(animation_system, [&]() { animation_system.Update(job_system); });
+    system_scheduler.Schedule(projectile_lifecycle_system, [&]() { projectile_lifecycle_system.Update(SDL_GetTicks()); });
+    system_scheduler.Schedule(collision_system, [&]() { collision_system.Update(registry); });
+    system_scheduler.Schedule(projectile_emit_system, [&]() { projectile_emit_system.Update(registry, SDL_GetTicks()); });
+    system_scheduler.Schedule(camera_movement_system, [&]() { camera_movement_system.Update(camera); });
+    system_scheduler.Schedule(script_system, [&]() { script_system.Update(delta_time, SDL_GetTicks()); });
+    system_scheduler.Run(*job_system);
+
+    // The collision handlers run once the systems are done.
+    collision_system.EmitCollisionEvents(event_bus);
 }
 
 void Game::Render() {
@@ -258,9 +288,9 @@ void Game::Render() {
 
     //SDL_DestroyTexture(texture);
 
-    registry->GetSystem<RenderSystem>().Update(renderer, asset_store, camera);
+    registry->GetSystem<RenderSystem>().Update(registry, renderer, asset_store, camera);
     registry->GetSystem<RenderTextSystem>().Update(renderer, asset_store, camera);
-    registry->GetSystem<RenderHealthTextSystem>().Update(renderer, asset_store, camera);
+    registry->GetSystem<RenderHealthTextSystem>().Update(registry, renderer, asset_store, camera);
     registry->GetSystem<RenderHealthBarSystem>().Update(renderer, camera);
     if (is_debug) {
         registry->GetSystem<RenderColliderSystem>().Update(renderer, camera);
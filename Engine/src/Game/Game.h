@@ -3,6 +3,8 @@
 #include <sol/sol.hpp>
 
 #include "../ECS/ECS.h"
+#include "../ECS/SystemScheduler.h"
+#include "../JobSystem/JobSystem.h"
 #include "../AssetStore/AssetStore.h"
 #include "../EventBus/EventBus.h"
 
@@ -24,6 +26,8 @@ private:
     std::unique_ptr<Registry> registry;
     std::unique_ptr<AssetStore> asset_store;
     std::unique_ptr<EventBus> event_bus;
+    std::unique_ptr<JobSystem> job_system;
+    SystemScheduler system_scheduler;
 
 public:
     Game();
@@ -24,6 +24,172 @@
 #include "../Components/TextLabelComponent.h"
 #include "../Components/ScriptComponent.h"
 
+#include "../Physics/Broadphase.h"
+#include "../Systems/CollisionSystem.h"
+
+// Adds the components described by a level table to target, which is an Entity or a Prefab.
+template <typename TTarget>
+static void AddComponents(const sol::table& components, TTarget& target) {
+    // Transform
+    sol::optional<sol::table> transform = components["transform"];
+    if (transform != sol::nullopt) {
+        target.template AddComponent<TransformComponent>(
+            glm::vec2(
+                components["transform"]["position"]["x"],
+                components["transform"]["position"]["y"]
+            ),
+            glm::vec2(
+                components["transform"]["scale"]["x"].get_or(1.0),
+                components["transform"]["scale"]["y"].get_or(1.0)
+            ),
+            components["transform"]["rotation"].get_or(0.0)
+            );
+    }
+
+    // RigidBody
+    sol::optional<sol::table> rigidbody = components["rigidbody"];
+    if (rigidbody != sol::nullopt) {
+        target.template AddComponent<RigidBodyComponent>(
+            glm::vec2(
+                components["rigidbody"]["velocity"]["x"].get_or(0.0),
+                components["rigidbody"]["velocity"]["y"].get_or(0.0)
+            )
+            );
+    }
+
+    // Sprite
+    sol::optional<sol::table> sprite = components["sprite"];
+    if (sprite != sol::nullopt) {
+        target.template AddComponent<SpriteComponent>(
+            components["sprite"]["texture_asset_id"],
+            components["sprite"]["width"],
+            components["sprite"]["height"],
+            components["sprite"]["z_index"].get_or(1),
+            components["sprite"]["fixed"].get_or(false),
+            components["sprite"]["src_rect_x"].get_or(0),
+            components["sprite"]["src_rect_y"].get_or(0)
+            );
+    }
+
+    // Animation
+    sol::optional<sol::table> animation = components["animation"];
+    if (animation != sol::nullopt) {
+        target.template AddComponent<AnimationComponent>(
+            components["animation"]["num_frames"].get_or(1),
+            components["animation"]["speed_rate"].get_or(1)
+            );
+    }
+
+    // BoxCollider
+    sol::optional<sol::table> collider = components["boxcollider"];
+    if (collider != sol::nullopt) {
+        // Optional collision layer name, and list of the layer names the collider collides with.
+        uint32_t layer = DEFAULT_COLLISION_LAYER;
+        sol::optional<std::string> layer_name = components["boxcollider"]["layer"];
+        if (layer_name != sol::nullopt) {
+            layer = GetCollisionLayer(layer_name.value());
+        }
+        uint32_t collision_mask = ALL_COLLISION_LAYERS;
+        sol::optional<sol::table> collides_with = components["boxcollider"]["collides_with"];
+        if (collides_with != sol::nullopt) {
+            collision_mask = 0;
+            sol::table collides_with_layers = collides_with.value();
+            // The list may start at [0] like the other level lists, or at 1 like a plain Lua list.
+            for (int k = 0; ; k++) {
+                sol::optional<std::string> collides_with_layer = collides_with_layers[k];
+                if (collides_with_layer == sol::nullopt) {
+                    if (k == 0) {
+                        continue;
+                    }
+                    break;
+                }
+                collision_mask |= GetCollisionLayer(collides_with_layer.value());
+            }
+        }
+        target.template AddComponent<BoxColliderComponent>(
+            components["boxcollider"]["width"],
+            components["boxcollider"]["height"],
+            glm::vec2(
+                components["boxcollider"]["offset"]["x"].get_or(0),
+                components["boxcollider"]["offset"]["y"].get_or(0)
+            ),
+            layer,
+            collision_mask,
+            components["boxcollider"]["static"].get_or(false)
+            );
+    }
+
+    // Health
+    sol::optional<sol::table> health = components["health"];
+    if (health != sol::nullopt) {
+        target.template AddComponent<HealthComponent>(
+            static_cast<int>(components["health"]["health_percentage"].get_or(100))
+            );
+    }
+
+    // HealthLabel
+    sol::optional<sol::table> health_label = components["health_label"];
+    if (health_label != sol::nullopt) {
+        sol::table font_color = components["health_label"]["color"];
+        int font_color_r = static_cast<int>(font_color["r"].get_or(0));
+        int font_color_g = static_cast<int>(font_color["g"].get_or(0));
+        int font_color_b = static_cast<int>(font_color["b"].get_or(0));
+        SDL_Color font_color_rgb = {font_color_r, font_color_g, font_color_b};
+        target.template AddComponent<HealthLabelComponent>(components["health_label"]["font"], font_color_rgb);
+    }
+
+    // ProjectileEmitter
+    sol::optional<sol::table> projectile_emitter = components["projectile_emitter"];
+    if (projectile_emitter != sol::nullopt) {
+        target.template AddComponent<ProjectileEmitterComponent>(
+            glm::vec2(
+                components["projectile_emitter"]["projectile_velocity"]["x"],
+                components["projectile_emitter"]["projectile_velocity"]["y"]
+            ),
+            static_cast<int>(components["projectile_emitter"]["repeat_frequency"].get_or(1)) * 1000,
+            static_cast<int>(components["projectile_emitter"]["projectile_duration"].get_or(10)) * 1000,
+            static_cast<int>(components["projectile_emitter"]["hit_percentage_damage"].get_or(10)),
+            components["projectile_emitter"]["friendly"].get_or(false)
+            );
+    }
+
+    // CameraFollow
+    sol::optional<sol::table> camera_follow = components["camera_follow"];
+    if (camera_follow != sol::nullopt) {
+        target.template AddComponent<CameraFollowComponent>();
+    }
+
+    // KeyboardControlled
+    sol::optional<sol::table> keyboard_controller = components["keyboard_controller"];
+    if (keyboard_controller != sol::nullopt) {
+        target.template AddComponent<KeyboardControlledComponent>(
+            glm::vec2(
+                components["keyboard_controller"]["up_velocity"]["x"],
+                components["keyboard_controller"]["up_velocity"]["y"]
+            ),
+            glm::vec2(
+                components["keyboard_controller"]["right_velocity"]["x"],
+                components["keyboard_controller"]["right_velocity"]["y"]
+            ),
+            glm::vec2(
+                components["keyboard_controller"]["down_velocity"]["x"],
+                components["keyboard_controller"]["down_velocity"]["y"]
+            ),
+            glm::vec2(
+                components["keyboard_controller"]["left_velocity"]["x"],
+                components["keyboard_controller"]["left_velocity"]["y"]
+            )
+            );
+    }
+
+    // Script
+    sol::optional<sol::table> script = components["on_update_script"];
+    if (script != sol::nullopt) {
+        sol::function func = components["on_update_script"][0];
+        target.template AddComponent<ScriptComponent>(func);
+    }
+}
+
 LevelLoader::LevelLoader() {
     Logger::Log("LevelLoader constructor called.");
 }
@@ -124,6 +290,10 @@ void LevelLoader::LoadLevel(
     Game::map_width = tilemap_num_cols * tilemap_tile_size * tilemap_scale;
     Game::map_height = tilemap_num_rows * tilemap_tile_size * tilemap_scale;
 
+    // Size the pools once for all the tiles.
+    registry->Reserve<TransformComponent>(static_cast<int>(tilemap_vec.size()));
+    registry->Reserve<SpriteComponent>(static_cast<int>(tilemap_vec.size()));
+
     std::vector<Entity> tiles;
     for (auto& tilemap_tile : tilemap_vec) {
         Entity tile = registry->CreateEntity();
@@ -133,6 +303,52 @@ void LevelLoader::LoadLevel(
     }
 
 
+    // ===========================================================================
+    // Read the level broadphase (optional)
+    // grid (default), tree or sweep_and_prune, see CreateBroadphase().
+    // ===========================================================================
+    sol::optional<std::string> broadphase_name = level["broadphase"];
+    std::unique_ptr<IBroadphase> broadphase = CreateBroadphase(broadphase_name.value_or("grid"));
+    if (!broadphase) {
+        Logger::Err("Unknown broadphase " + *broadphase_name + " in Level" + std::to_string(level_num) + ".lua, using the grid");
+        broadphase = CreateBroadphase("grid");
+    }
+    registry->GetSystem<CollisionSystem>().SetBroadphase(std::move(broadphase));
+
+    // ===========================================================================
+    // Read the level prefabs (optional)
+    // Each prefab has a name, an optional group and components, and entities refer to it with prefab = name.
+    // ===========================================================================
+    // The prefabs of the previous level go away, with their parked entities.
+    registry->RemovePrefabs();
+    sol::optional<sol::table> has_prefabs = level["prefabs"];
+    if (has_prefabs != sol::nullopt) {
+        sol::table prefabs = level["prefabs"];
+
+        int k = 0;
+        while (true) {
+            sol::optional<sol::table> has_prefab = prefabs[k];
+            if (has_prefab == sol::nullopt) {
+                break;
+            }
+            sol::table prefab_table = prefabs[k];
+            std::string prefab_name = prefab_table["name"];
+
+            Prefab prefab;
+            sol::optional<std::string> group = prefab_table["group"];
+            if (group != sol::nullopt) {
+                prefab.Group(*group);
+            }
+            sol::optional<sol::table> has_components = prefab_table["components"];
+            if (has_components != sol::nullopt) {
+                AddComponents(prefab_table["components"], prefab);
+            }
+            registry->AddPrefab(prefab_name, std::move(prefab));
+            Logger::Log("New prefab loaded to the registry, name: " + prefab_name);
+            k++;
+        }
+    }
+
     // ===========================================================================
     // Create entities
     // ===========================================================================
@@ -146,155 +362,33 @@ void LevelLoader::LoadLevel(
         }
         sol::table entity = entities[j];
 
-        Entity new_entity = registry->CreateEntity();
+        // Entities made from a prefab start with its groups and components, their own components replace the prefab ones.
+        const Prefab* prefab = nullptr;
+        sol::optional<std::string> prefab_name = entity["prefab"];
+        if (prefab_name != sol::nullopt) {
+            prefab = registry->GetPrefab(*prefab_name);
+            if (!prefab) {
+                Logger::Err("Unknown prefab: " + *prefab_name);
+            }
+        }
+        Entity new_entity = prefab ? registry->Spawn(*prefab) : registry->CreateEntity();
 
         // Tag
         sol::optional<std::string> tag = entity["tag"];
         if (tag != sol::nullopt) {
-            new_entity.Tag(entity["tag"]);
+            new_entity.Tag(*tag);
         }
 
         // Group
         sol::optional<std::string> group = entity["group"];
         if (group != sol::nullopt) {
-            new_entity.Group(entity["group"]);
+            new_entity.Group(*group);
         }
 
         // Components
         sol::optional<sol::table> has_components = entity["components"];
         if (has_components != sol::nullopt) {
-            // Transform
-            sol::optional<sol::table> transform = entity["components"]["transform"];
-            if (transform != sol::nullopt) {
-                new_entity.AddComponent<TransformComponent>(
-                    glm::vec2(
-                        entity["components"]["transform"]["position"]["x"],
-                        entity["components"]["transform"]["position"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["transform"]["scale"]["x"].get_or(1.0),
-                        entity["components"]["transform"]["scale"]["y"].get_or(1.0)
-                    ),
-                    entity["components"]["transform"]["rotation"].get_or(0.0)
-                    );
-            }
-
-            // RigidBody
-            sol::optional<sol::table> rigidbody = entity["components"]["rigidbody"];
-            if (rigidbody != sol::nullopt) {
-                new_entity.AddComponent<RigidBodyComponent>(
-                    glm::vec2(
-                        entity["components"]["rigidbody"]["velocity"]["x"].get_or(0.0),
-                        entity["components"]["rigidbody"]["velocity"]["y"].get_or(0.0)
-                    )
-                    );
-            }
-
-            // Sprite
-            sol::optional<sol::table> sprite = entity["components"]["sprite"];
-            if (sprite != sol::nullopt) {
-                new_entity.AddComponent<SpriteComponent>(
-                    entity["components"]["sprite"]["texture_asset_id"],
-                    entity["components"]["sprite"]["width"],
-                    entity["components"]["sprite"]["height"],
-                    entity["components"]["sprite"]["z_index"].get_or(1),
-                    entity["components"]["sprite"]["fixed"].get_or(false),
-                    entity["components"]["sprite"]["src_rect_x"].get_or(0),
-                    entity["components"]["sprite"]["src_rect_y"].get_or(0)
-                    );
-            }
-
-            // Animation
-            sol::optional<sol::table> animation = entity["components"]["animation"];
-            if (animation != sol::nullopt) {
-                new_entity.AddComponent<AnimationComponent>(
-                    entity["components"]["animation"]["num_frames"].get_or(1),
-                    entity["components"]["animation"]["speed_rate"].get_or(1)
-                    );
-            }
-
-            // BoxCollider
-            sol::optional<sol::table> collider = entity["components"]["boxcollider"];
-            if (collider != sol::nullopt) {
-                new_entity.AddComponent<BoxColliderComponent>(
-                    entity["components"]["boxcollider"]["width"],
-                    entity["components"]["boxcollider"]["height"],
-                    glm::vec2(
-                        entity["components"]["boxcollider"]["offset"]["x"].get_or(0),
-                        entity["components"]["boxcollider"]["offset"]["y"].get_or(0)
-                    )
-                    );
-            }
-
-            // Health
-            sol::optional<sol::table> health = entity["components"]["health"];
-            if (health != sol::nullopt) {
-                new_entity.AddComponent<HealthComponent>(
-                    static_cast<int>(entity["components"]["health"]["health_percentage"].get_or(100))
-                    );
-            }
-
-            // HealthLabel
-            sol::optional<sol::table> health_label = entity["components"]["health_label"];
-            if (health_label != sol::nullopt) {
-                sol::table font_color = entity["components"]["health_label"]["color"];
-                int font_color_r = static_cast<int>(font_color["r"].get_or(0));
-                int font_color_g = static_cast<int>(font_color["g"].get_or(0));
-                int font_color_b = static_cast<int>(font_color["b"].get_or(0));
-                SDL_Color font_color_rgb = {font_color_r, font_color_g, font_color_b};
-                new_entity.AddComponent<HealthLabelComponent>(entity["components"]["health_label"]["font"], font_color_rgb);
-            }
-
-            // ProjectileEmitter
-            sol::optional<sol::table> projectile_emitter = entity["components"]["projectile_emitter"];
-            if (projectile_emitter != sol::nullopt) {
-                new_entity.AddComponent<ProjectileEmitterComponent>(
-                    glm::vec2(
-                        entity["components"]["projectile_emitter"]["projectile_velocity"]["x"],
-                        entity["components"]["projectile_emitter"]["projectile_velocity"]["y"]
-                    ),
-                    static_cast<int>(entity["components"]["projectile_emitter"]["repeat_frequency"].get_or(1)) * 1000,
-                    static_cast<int>(entity["components"]["projectile_emitter"]["projectile_duration"].get_or(10)) * 1000,
-                    static_cast<int>(entity["components"]["projectile_emitter"]["hit_percentage_damage"].get_or(10)),
-                    entity["components"]["projectile_emitter"]["friendly"].get_or(false)
-                    );
-            }
-
-            // CameraFollow
-            sol::optional<sol::table> camera_follow = entity["components"]["camera_follow"];
-            if (camera_follow != sol::nullopt) {
-                new_entity.AddComponent<CameraFollowComponent>();
-            }
-
-            // KeyboardControlled
-            sol::optional<sol::table> keyboard_controller = entity["components"]["keyboard_controller"];
-            if (keyboard_controller != sol::nullopt) {
-                new_entity.AddComponent<KeyboardControlledComponent>(
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["up_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["up_velocity"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["right_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["right_velocity"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["down_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["down_velocity"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["left_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["left_velocity"]["y"]
-                    )
-                    );
-            }
-
-            // Script
-            sol::optional<sol::table> script = entity["components"]["on_update_script"];
-            if (script != sol::nullopt) {
-                sol::function func = entity["components"]["on_update_script"][0];
-                new_entity.AddComponent<ScriptComponent>(func);
-            }
+            AddComponents(entity["components"], new_entity);
         }
         j++;
     }
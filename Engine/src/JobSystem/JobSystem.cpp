@@ -0,0 +1,110 @@
+#include "JobSystem.h"
+#include "../Logger/Logger.h"
+
+static thread_local unsigned int current_thread_index = 0;
+
+JobSystem::JobSystem(unsigned int num_workers) {
+    for (unsigned int i = 0; i <= num_workers; i++) {
+        queues.push_back(std::make_unique<JobQueue>());
+    }
+    for (unsigned int i = 1; i <= num_workers; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+    Logger::Log("JobSystem constructor called with " + std::to_string(num_workers) + " worker threads.");
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        is_stopping = true;
+    }
+    wake_up.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    Logger::Log("JobSystem destructor called.");
+}
+
+unsigned int JobSystem::GetNumThreads() const {
+    return static_cast<unsigned int>(queues.size());
+}
+
+unsigned int JobSystem::GetThreadIndex() {
+    return current_thread_index;
+}
+
+void JobSystem::Submit(Job job, JobCounter& counter) {
+    counter.num_pending.fetch_add(1, std::memory_order_relaxed);
+
+    if (workers.empty()) {
+        job();
+        counter.num_pending.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    {
+        JobQueue& queue = *queues[current_thread_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.emplace_back(std::move(job), &counter);
+    }
+    num_queued_jobs.fetch_add(1, std::memory_order_release);
+
+    // Take the sleep lock so a worker that is about to sleep cannot miss the notification.
+    { std::lock_guard<std::mutex> lock(sleep_mutex); }
+    wake_up.notify_one();
+}
+
+bool JobSystem::TryRunJob(unsigned int thread_index) {
+    std::pair<Job, JobCounter*> job;
+    bool has_job = false;
+
+    // Newest job from our own queue first, then the oldest job of the other queues.
+    {
+        JobQueue& queue = *queues[thread_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            has_job = true;
+        }
+    }
+    for (size_t i = 1; !has_job && i < queues.size(); i++) {
+        JobQueue& queue = *queues[(thread_index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            has_job = true;
+        }
+    }
+    if (!has_job) {
+        return false;
+    }
+
+    num_queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+    job.first();
+    job.second->num_pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::WorkerLoop(unsigned int thread_index) {
+    current_thread_index = thread_index;
+    while (true) {
+        if (TryRunJob(thread_index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake_up.wait(lock, [this]() { return is_stopping || num_queued_jobs.load(std::memory_order_acquire) > 0; });
+        if (is_stopping) {
+            return;
+        }
+    }
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    while (!counter.IsDone()) {
+        if (!TryRunJob(current_thread_index)) {
+            std::this_thread::yield();
+        }
+    }
+}
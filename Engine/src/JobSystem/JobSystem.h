@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::function<void()> Job;
+
+const size_t CACHE_LINE_SIZE = 64;
+
+// ParallelFor() splits its range in about this many chunks per thread, so that threads
+// that finish early can steal the remaining chunks.
+const size_t PARALLEL_FOR_CHUNKS_PER_THREAD = 4;
+
+// Counts the jobs of a group that are still running, so that the group can be waited on.
+class JobCounter
+{
+private:
+    std::atomic<int> num_pending{0};
+    friend class JobSystem;
+
+public:
+    bool IsDone() const {
+        return num_pending.load(std::memory_order_acquire) == 0;
+    }
+};
+
+// A pool of worker threads with one job queue per thread.
+// A thread pops the newest job from its own queue and, when it runs out of work,
+// steals the oldest job from the queue of another thread.
+// The thread that created the job system takes part too, while it waits for a group of jobs.
+class JobSystem
+{
+private:
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<std::pair<Job, JobCounter*>> jobs;
+    };
+
+    // Queue 0 belongs to the thread that created the job system, queues 1..n to the workers.
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> workers;
+
+    // Idle workers sleep until a job is submitted.
+    std::atomic<int> num_queued_jobs{0};
+    std::mutex sleep_mutex;
+    std::condition_variable wake_up;
+    bool is_stopping = false;
+
+    void WorkerLoop(unsigned int thread_index);
+    bool TryRunJob(unsigned int thread_index);
+
+public:
+    // With num_workers = 0 every job runs immediately on the submitting thread.
+    JobSystem(unsigned int num_workers);
+    ~JobSystem();
+
+    // Number of threads that may run jobs (the workers plus the creating thread).
+    unsigned int GetNumThreads() const;
+
+    // Index of the calling thread, in [0, GetNumThreads()): 0 for the creating thread, 1..n for the workers.
+    static unsigned int GetThreadIndex();
+
+    // Queue a job on the calling thread's queue, counted in counter.
+    void Submit(Job job, JobCounter& counter);
+
+    // Run queued jobs until every job counted in counter has finished.
+    void Wait(JobCounter& counter);
+
+    // Split [0, count) into chunks of at least min_chunk_size items and call func(begin, end, thread_index)
+    // for each of them across the threads, then wait for all of them.
+    // The calling thread processes the first chunk itself.
+    template <typename TFunc> void ParallelFor(size_t count, size_t min_chunk_size, TFunc&& func);
+};
+
+// One T per job system thread, each on its own cache lines so that threads filling their
+// own scratch data never write to the same cache line.
+// Example: collect side effects per thread inside a ParallelFor() and apply them after the join.
+template <typename T>
+class PerThread
+{
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        T value;
+    };
+    std::vector<Slot> slots;
+
+public:
+    // Make sure there is a slot for every thread of the job system.
+    void Resize(unsigned int num_threads) {
+        if (slots.size() < num_threads) {
+            slots.resize(num_threads);
+        }
+    }
+
+    unsigned int GetSize() const { return static_cast<unsigned int>(slots.size()); }
+    T& operator[](unsigned int thread_index) { return slots[thread_index].value; }
+};
+
+template <typename TFunc>
+void JobSystem::ParallelFor(size_t count, size_t min_chunk_size, TFunc&& func) {
+    if (count == 0) {
+        return;
+    }
+    const size_t num_chunks = GetNumThreads() * PARALLEL_FOR_CHUNKS_PER_THREAD;
+    const size_t chunk_size = std::max<size_t>(std::max<size_t>(min_chunk_size, (count + num_chunks - 1) / num_chunks), 1);
+
+    if (workers.empty() || chunk_size >= count) {
+        func(size_t(0), count, GetThreadIndex());
+        return;
+    }
+
+    JobCounter counter;
+    for (size_t begin = chunk_size; begin < count; begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, count);
+        Submit([&func, begin, end]() { func(begin, end, GetThreadIndex()); }, counter);
+    }
+    func(size_t(0), chunk_size, GetThreadIndex());
+    Wait(counter);
+}
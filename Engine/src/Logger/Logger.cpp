@@ -1,16 +1,22 @@
 #include "Logger.h"
 
 std::vector<LogEntry> Logger::messages;
+std::mutex Logger::messages_mutex;
 
 void Logger::Log(const std::string& message) {
     // TODO: Print on the console the message:
     // LOG: [ 12/Oct/2020 09:13:17 ] - Here goes the message ...
     // This should be displayed in green.
+    std::lock_guard<std::mutex> lock(messages_mutex);
     time_t rawtime;
     struct tm* t = new tm;
     char buffer[80];
     time(&rawtime);
+#ifdef _WIN32
     localtime_s(t, &rawtime);
+#else
+    localtime_r(&rawtime, t);
+#endif
     strftime(buffer, 80, "%d-%b-%Y %H:%M:%S", t);
     std::cout << "\033[32m" << "LOG | " << buffer << " - " << message << "\033[0m" << std::endl;
 
@@ -24,11 +30,16 @@ void Logger::Err(const std::string& message) {
     // TODO: Print on the console the message:
      // ERR: [ 12/Oct/2020 09:13:17 ] - Here goes the message ...
      // This should be displayed in red.
+    std::lock_guard<std::mutex> lock(messages_mutex);
     time_t rawtime;
     struct tm* t = new tm;
     char buffer[80];
     time(&rawtime);
+#ifdef _WIN32
     localtime_s(t, &rawtime);
+#else
+    localtime_r(&rawtime, t);
+#endif
     strftime(buffer, 80, "%d-%b-%Y %H:%M:%S", t);
     std::cout << "\033[31m" << "ERR | " << buffer << " - " << message << "\033[0m" << std::endl;
 
@@ -37,3 +48,8 @@ void Logger::Err(const std::string& message) {
     log_entry.message = "ERR | " + static_cast<std::string>(buffer) + " - " + message;
     messages.push_back(log_entry);
 }
+
+std::vector<LogEntry> Logger::GetMessages() {
+    std::lock_guard<std::mutex> lock(messages_mutex);
+    return messages;
+}
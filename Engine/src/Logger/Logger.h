@@ -4,6 +4,7 @@
 #include <chrono> 
 #include <ctime>
 #include <time.h>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -19,8 +20,14 @@ struct LogEntry {
 };
 
 class Logger {
-public:
+private:
     static std::vector<LogEntry> messages;
+    // Systems may log from worker threads.
+    static std::mutex messages_mutex;
+
+public:
     static void Log(const std::string& message);
     static void Err(const std::string& message);
+    // Copy of the messages logged so far, safe to read while jobs are still logging.
+    static std::vector<LogEntry> GetMessages();
 };
@@ -0,0 +1,108 @@
+#include "AabbKernel.h"
+
+#if !defined(AABB_KERNEL_SCALAR) && defined(__AVX2__)
+#define AABB_KERNEL_AVX2
+#include <immintrin.h>
+#elif !defined(AABB_KERNEL_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define AABB_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(std::pair<int, int>) == 2 * sizeof(int), "the kernels load the pairs as packed ints");
+
+// Tests the pairs from first to count one at a time. Every pair is written, but the output only moves past the overlapping ones,
+// so there is no branch to mispredict.
+static size_t FindOverlappingPairsScalar(const PackedAabbs& boxes, const std::pair<int, int>* pairs, size_t first, size_t count, std::pair<int, int>* overlapping_pairs, size_t num_overlapping_pairs) {
+    const float* min_x = boxes.min_x.data();
+    const float* min_y = boxes.min_y.data();
+    const float* max_x = boxes.max_x.data();
+    const float* max_y = boxes.max_y.data();
+    for (size_t i = first; i < count; i++) {
+        const int a = pairs[i].first;
+        const int b = pairs[i].second;
+        const bool is_overlapping = (min_x[a] <= max_x[b]) & (max_x[a] >= min_x[b]) & (min_y[a] <= max_y[b]) & (max_y[a] >= min_y[b]);
+        overlapping_pairs[num_overlapping_pairs] = pairs[i];
+        num_overlapping_pairs += is_overlapping;
+    }
+    return num_overlapping_pairs;
+}
+
+#if defined(AABB_KERNEL_AVX2)
+
+size_t FindOverlappingPairs(const PackedAabbs& boxes, const std::pair<int, int>* pairs, size_t count, std::pair<int, int>* overlapping_pairs) {
+    const float* min_x = boxes.min_x.data();
+    const float* min_y = boxes.min_y.data();
+    const float* max_x = boxes.max_x.data();
+    const float* max_y = boxes.max_y.data();
+    size_t num_overlapping_pairs = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Split 8 interleaved pairs into the 8 first and the 8 second indices. The shuffle works within 128-bit lanes,
+        // so the 64-bit permute puts the indices back in pair order.
+        const __m256 pairs_low = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pairs + i)));
+        const __m256 pairs_high = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pairs + i + 4)));
+        const __m256i a = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(pairs_low, pairs_high, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+        const __m256i b = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(pairs_low, pairs_high, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+
+        const __m256 overlaps_x = _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_i32gather_ps(min_x, a, 4), _mm256_i32gather_ps(max_x, b, 4), _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_i32gather_ps(max_x, a, 4), _mm256_i32gather_ps(min_x, b, 4), _CMP_GE_OQ));
+        const __m256 overlaps_y = _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_i32gather_ps(min_y, a, 4), _mm256_i32gather_ps(max_y, b, 4), _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_i32gather_ps(max_y, a, 4), _mm256_i32gather_ps(min_y, b, 4), _CMP_GE_OQ));
+        const int mask = _mm256_movemask_ps(_mm256_and_ps(overlaps_x, overlaps_y));
+        for (int k = 0; k < 8; k++) {
+            overlapping_pairs[num_overlapping_pairs] = pairs[i + k];
+            num_overlapping_pairs += (mask >> k) & 1;
+        }
+    }
+    return FindOverlappingPairsScalar(boxes, pairs, i, count, overlapping_pairs, num_overlapping_pairs);
+}
+
+const char* GetAabbKernelName() {
+    return "avx2";
+}
+
+#elif defined(AABB_KERNEL_SSE2)
+
+size_t FindOverlappingPairs(const PackedAabbs& boxes, const std::pair<int, int>* pairs, size_t count, std::pair<int, int>* overlapping_pairs) {
+    const float* min_x = boxes.min_x.data();
+    const float* min_y = boxes.min_y.data();
+    const float* max_x = boxes.max_x.data();
+    const float* max_y = boxes.max_y.data();
+    size_t num_overlapping_pairs = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // SSE2 has no gather, the sides are loaded one by one (_mm_set_ps takes the last lane first).
+        const int a0 = pairs[i].first, a1 = pairs[i + 1].first, a2 = pairs[i + 2].first, a3 = pairs[i + 3].first;
+        const int b0 = pairs[i].second, b1 = pairs[i + 1].second, b2 = pairs[i + 2].second, b3 = pairs[i + 3].second;
+        const __m128 overlaps_x = _mm_and_ps(
+            _mm_cmple_ps(_mm_set_ps(min_x[a3], min_x[a2], min_x[a1], min_x[a0]), _mm_set_ps(max_x[b3], max_x[b2], max_x[b1], max_x[b0])),
+            _mm_cmpge_ps(_mm_set_ps(max_x[a3], max_x[a2], max_x[a1], max_x[a0]), _mm_set_ps(min_x[b3], min_x[b2], min_x[b1], min_x[b0])));
+        const __m128 overlaps_y = _mm_and_ps(
+            _mm_cmple_ps(_mm_set_ps(min_y[a3], min_y[a2], min_y[a1], min_y[a0]), _mm_set_ps(max_y[b3], max_y[b2], max_y[b1], max_y[b0])),
+            _mm_cmpge_ps(_mm_set_ps(max_y[a3], max_y[a2], max_y[a1], max_y[a0]), _mm_set_ps(min_y[b3], min_y[b2], min_y[b1], min_y[b0])));
+        const int mask = _mm_movemask_ps(_mm_and_ps(overlaps_x, overlaps_y));
+        for (int k = 0; k < 4; k++) {
+            overlapping_pairs[num_overlapping_pairs] = pairs[i + k];
+            num_overlapping_pairs += (mask >> k) & 1;
+        }
+    }
+    return FindOverlappingPairsScalar(boxes, pairs, i, count, overlapping_pairs, num_overlapping_pairs);
+}
+
+const char* GetAabbKernelName() {
+    return "sse2";
+}
+
+#else
+
+size_t FindOverlappingPairs(const PackedAabbs& boxes, const std::pair<int, int>* pairs, size_t count, std::pair<int, int>* overlapping_pairs) {
+    return FindOverlappingPairsScalar(boxes, pairs, 0, count, overlapping_pairs, 0);
+}
+
+const char* GetAabbKernelName() {
+    return "scalar";
+}
+
+#endif
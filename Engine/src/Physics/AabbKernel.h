@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Broadphase.h"
+
+// Boxes stored as one array per side, so a batch of boxes is tested with a few vector instructions.
+struct PackedAabbs
+{
+    std::vector<float> min_x;
+    std::vector<float> min_y;
+    std::vector<float> max_x;
+    std::vector<float> max_y;
+
+    void Clear() {
+        min_x.clear();
+        min_y.clear();
+        max_x.clear();
+        max_y.clear();
+    }
+
+    void Add(const Aabb& box) {
+        min_x.push_back(box.min_x);
+        min_y.push_back(box.min_y);
+        max_x.push_back(box.max_x);
+        max_y.push_back(box.max_y);
+    }
+
+    size_t GetSize() const { return min_x.size(); }
+};
+
+// Write to overlapping_pairs the pairs of indices into boxes whose boxes overlap (same test as Overlaps()),
+// in the order of pairs, and return how many there are. overlapping_pairs must hold room for count pairs.
+// Tests 8 pairs at a time with AVX2, 4 at a time with SSE2, or one at a time otherwise,
+// depending on the instruction sets the engine is compiled for (AABB_KERNEL_SCALAR forces the scalar loop).
+size_t FindOverlappingPairs(const PackedAabbs& boxes, const std::pair<int, int>* pairs, size_t count, std::pair<int, int>* overlapping_pairs);
+
+// Name of the instruction set FindOverlappingPairs() uses: "avx2", "sse2" or "scalar".
+const char* GetAabbKernelName();
@@ -0,0 +1,18 @@
+#include "Broadphase.h"
+
+#include "SpatialGrid.h"
+#include "DynamicAabbTree.h"
+#include "SweepAndPrune.h"
+
+std::unique_ptr<IBroadphase> CreateBroadphase(const std::string& name) {
+    if (name == "grid") {
+        return std::make_unique<SpatialGrid>();
+    }
+    if (name == "tree") {
+        return std::make_unique<DynamicAabbTree>();
+    }
+    if (name == "sweep_and_prune") {
+        return std::make_unique<SweepAndPrune>();
+    }
+    return nullptr;
+}
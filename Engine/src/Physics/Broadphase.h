@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CollisionLayers.h"
+
+// Axis-aligned bounding box, in world coordinates. Boxes that touch are considered overlapping.
+struct Aabb
+{
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+};
+
+inline bool Overlaps(const Aabb& a, const Aabb& b) {
+    return a.min_x <= b.max_x && a.max_x >= b.min_x && a.min_y <= b.max_y && a.max_y >= b.min_y;
+}
+
+// Collision layer of a box, and the layers it collides with.
+struct CollisionFilter
+{
+    uint32_t layer;
+    uint32_t mask;
+};
+
+inline bool CanCollide(const CollisionFilter& a, const CollisionFilter& b) {
+    return CanCollide(a.layer, a.mask, b.layer, b.mask);
+}
+
+// Finds the pairs of boxes that may overlap, so the exact collision test only runs on those.
+// Each implementation suits a different kind of scene, so levels pick one by name (see CreateBroadphase()).
+class IBroadphase
+{
+public:
+    virtual ~IBroadphase() = default;
+
+    // Give the broadphase the boxes of the current frame and their collision filters, in a world of width x height pixels.
+    // ids identify the boxes from one frame to the next (e.g. entity ids): they must be unique and not negative.
+    // The boxes may come in any order, and boxes whose id is missing are dropped.
+    virtual void Update(const Aabb* boxes, const CollisionFilter* filters, const int* ids, int count, float width, float height) = 0;
+
+    // Append the pairs (a, b), a < b, of indices into the boxes of the last Update() that may overlap, each pair once.
+    // Every overlapping pair whose filters CanCollide() is found, the pairs of boxes that cannot collide are skipped
+    // before any box test. Some pairs may not overlap: the caller does the exact test.
+    virtual void FindCandidatePairs(std::vector<std::pair<int, int>>& pairs) = 0;
+
+    virtual const char* GetName() const = 0;
+};
+
+// Names of the broadphases that CreateBroadphase() knows.
+const char* const BROADPHASE_NAMES[] = {"grid", "tree", "sweep_and_prune"};
+
+// Create the broadphase called name (one of BROADPHASE_NAMES), or nullptr if there is none.
+std::unique_ptr<IBroadphase> CreateBroadphase(const std::string& name);
@@ -0,0 +1,98 @@
+#include "BroadphaseBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+void BroadphaseRecording::Clear() {
+    frames.clear();
+    boxes.clear();
+    filters.clear();
+    ids.clear();
+}
+
+void BroadphaseRecording::AddFrame(const Aabb* frame_boxes, const CollisionFilter* frame_filters, const int* frame_ids, int count, float width, float height) {
+    frames.push_back({boxes.size(), count, width, height});
+    boxes.insert(boxes.end(), frame_boxes, frame_boxes + count);
+    filters.insert(filters.end(), frame_filters, frame_filters + count);
+    ids.insert(ids.end(), frame_ids, frame_ids + count);
+}
+
+void BroadphaseRecording::ReplayFrame(int frame, IBroadphase& broadphase) const {
+    const Frame& recorded_frame = frames[frame];
+    broadphase.Update(boxes.data() + recorded_frame.first_box, filters.data() + recorded_frame.first_box, ids.data() + recorded_frame.first_box, recorded_frame.count, recorded_frame.width, recorded_frame.height);
+}
+
+// Test every pair of boxes, the candidates are the overlapping pairs themselves.
+static void FindBruteForcePairs(const Aabb* boxes, const CollisionFilter* filters, int count, std::vector<std::pair<int, int>>& pairs) {
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            if (Overlaps(boxes[i], boxes[j]) && CanCollide(filters[i], filters[j])) {
+                pairs.emplace_back(i, j);
+            }
+        }
+    }
+}
+
+// Put the pairs in a canonical order, so two pair lists can be compared whatever order the broadphases find them in.
+static void SortPairs(std::vector<std::pair<int, int>>& pairs) {
+    for (auto& pair : pairs) {
+        if (pair.first > pair.second) {
+            std::swap(pair.first, pair.second);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+}
+
+std::vector<BroadphaseBenchmarkResult> RunBroadphaseBenchmark(const BroadphaseRecording& recording) {
+    std::vector<BroadphaseBenchmarkResult> results;
+    std::vector<std::pair<int, int>> pairs;
+
+    // The reference pairs of every frame.
+    std::vector<std::vector<std::pair<int, int>>> expected_pairs(recording.GetNumFrames());
+    BroadphaseBenchmarkResult reference;
+    reference.name = "brute_force";
+    for (int frame = 0; frame < recording.GetNumFrames(); frame++) {
+        std::vector<std::pair<int, int>>& frame_pairs = expected_pairs[frame];
+        const auto start = std::chrono::steady_clock::now();
+        FindBruteForcePairs(recording.GetFrameBoxes(frame), recording.GetFrameFilters(frame), recording.GetFrameCount(frame), frame_pairs);
+        const auto end = std::chrono::steady_clock::now();
+        reference.milliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+
+        reference.num_candidate_pairs += frame_pairs.size();
+        reference.num_overlapping_pairs += frame_pairs.size();
+        SortPairs(frame_pairs);
+    }
+    results.push_back(reference);
+
+    for (const char* name : BROADPHASE_NAMES) {
+        std::unique_ptr<IBroadphase> broadphase = CreateBroadphase(name);
+        BroadphaseBenchmarkResult result;
+        result.name = name;
+
+        for (int frame = 0; frame < recording.GetNumFrames(); frame++) {
+            pairs.clear();
+            const auto start = std::chrono::steady_clock::now();
+            recording.ReplayFrame(frame, *broadphase);
+            broadphase->FindCandidatePairs(pairs);
+            const auto end = std::chrono::steady_clock::now();
+            result.milliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+
+            // The exact test is the same for every broadphase, so it is left out of the time.
+            const Aabb* boxes = recording.GetFrameBoxes(frame);
+            const CollisionFilter* filters = recording.GetFrameFilters(frame);
+            result.num_candidate_pairs += pairs.size();
+            pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [boxes, filters](const std::pair<int, int>& pair) {
+                return !CanCollide(filters[pair.first], filters[pair.second]) || !Overlaps(boxes[pair.first], boxes[pair.second]);
+            }), pairs.end());
+            result.num_overlapping_pairs += pairs.size();
+
+            SortPairs(pairs);
+            if (pairs != expected_pairs[frame]) {
+                result.num_mismatched_frames++;
+            }
+        }
+        results.push_back(result);
+    }
+    return results;
+}
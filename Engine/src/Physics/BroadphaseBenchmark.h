@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Broadphase.h"
+
+// Boxes of the colliders over a number of frames, so every broadphase can be replayed on the same motion.
+class BroadphaseRecording
+{
+private:
+    struct Frame
+    {
+        size_t first_box;
+        int count;
+        float width;
+        float height;
+    };
+    std::vector<Frame> frames;
+    std::vector<Aabb> boxes;
+    std::vector<CollisionFilter> filters;
+    std::vector<int> ids;
+
+public:
+    void Clear();
+    // Record the arguments of one IBroadphase::Update() call.
+    void AddFrame(const Aabb* frame_boxes, const CollisionFilter* frame_filters, const int* frame_ids, int count, float width, float height);
+    int GetNumFrames() const { return static_cast<int>(frames.size()); }
+    // Feed frame number frame to the broadphase.
+    void ReplayFrame(int frame, IBroadphase& broadphase) const;
+    int GetFrameCount(int frame) const { return frames[frame].count; }
+    const Aabb* GetFrameBoxes(int frame) const { return boxes.data() + frames[frame].first_box; }
+    const CollisionFilter* GetFrameFilters(int frame) const { return filters.data() + frames[frame].first_box; }
+};
+
+struct BroadphaseBenchmarkResult
+{
+    std::string name;
+    // Totals over all the frames of the recording.
+    size_t num_candidate_pairs = 0;
+    // Pairs that overlap and can collide.
+    size_t num_overlapping_pairs = 0;
+    // Frames where the overlapping pairs differ from the ones brute force finds (always 0 unless the broadphase is wrong).
+    int num_mismatched_frames = 0;
+    double milliseconds = 0.0;
+};
+
+// Replay the recording through a new broadphase of every kind in BROADPHASE_NAMES, timing the updates and
+// pair searches. Every broadphase must find the same overlapping pairs, only the candidates and the time differ.
+// The first result is the reference, "brute_force", which tests every pair of boxes: the overlapping pairs
+// of the other broadphases are compared with its own, frame by frame. Brute force is quadratic in the number
+// of boxes, keep the recordings of crowded scenes short.
+std::vector<BroadphaseBenchmarkResult> RunBroadphaseBenchmark(const BroadphaseRecording& recording);
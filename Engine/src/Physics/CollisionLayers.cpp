@@ -0,0 +1,21 @@
+#include "CollisionLayers.h"
+
+#include "../ECS/ECS.h"
+#include "../Logger/Logger.h"
+
+static NameTable& GetCollisionLayerNames() {
+    static NameTable collision_layer_names;
+    // The default layer is interned first, so it gets the first bit.
+    static const int default_layer = collision_layer_names.Intern("default");
+    (void)default_layer;
+    return collision_layer_names;
+}
+
+uint32_t GetCollisionLayer(const std::string& name) {
+    const int layer_index = GetCollisionLayerNames().Intern(name);
+    if (layer_index >= MAX_COLLISION_LAYERS) {
+        Logger::Err("Too many collision layers, cannot add layer " + name);
+        return 0;
+    }
+    return 1u << layer_index;
+}
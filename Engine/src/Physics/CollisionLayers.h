@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Collision layers are bits: a collider sits on one layer, and its mask holds the layers it collides with.
+// Two colliders are only tested against each other if each one is on a layer of the other's mask.
+const int MAX_COLLISION_LAYERS = 32;
+
+// Layer of the colliders that do not name one ("default").
+const uint32_t DEFAULT_COLLISION_LAYER = 1;
+const uint32_t ALL_COLLISION_LAYERS = 0xFFFFFFFF;
+
+inline bool CanCollide(uint32_t layer_a, uint32_t mask_a, uint32_t layer_b, uint32_t mask_b) {
+    return (layer_a & mask_b) != 0 && (layer_b & mask_a) != 0;
+}
+
+// Returns the bit of the layer called name, adding the layer the first time the name is used.
+// Returns 0 (no layer) if there are already MAX_COLLISION_LAYERS layers.
+uint32_t GetCollisionLayer(const std::string& name);
@@ -0,0 +1,281 @@
+#include "DynamicAabbTree.h"
+
+#include <algorithm>
+
+static Aabb Union(const Aabb& a, const Aabb& b) {
+    return {std::min(a.min_x, b.min_x), std::min(a.min_y, b.min_y), std::max(a.max_x, b.max_x), std::max(a.max_y, b.max_y)};
+}
+
+static float Perimeter(const Aabb& box) {
+    return 2.0f * ((box.max_x - box.min_x) + (box.max_y - box.min_y));
+}
+
+static bool Contains(const Aabb& outer, const Aabb& inner) {
+    return outer.min_x <= inner.min_x && outer.min_y <= inner.min_y && outer.max_x >= inner.max_x && outer.max_y >= inner.max_y;
+}
+
+static Aabb Fatten(const Aabb& box) {
+    return {box.min_x - AABB_TREE_MARGIN, box.min_y - AABB_TREE_MARGIN, box.max_x + AABB_TREE_MARGIN, box.max_y + AABB_TREE_MARGIN};
+}
+
+int DynamicAabbTree::AllocateNode() {
+    int node;
+    if (first_free_node != -1) {
+        node = first_free_node;
+        first_free_node = nodes[node].next;
+    } else {
+        node = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[node].parent = -1;
+    nodes[node].child1 = -1;
+    nodes[node].child2 = -1;
+    nodes[node].height = 0;
+    nodes[node].id = -1;
+    return node;
+}
+
+void DynamicAabbTree::FreeNode(int node) {
+    nodes[node].next = first_free_node;
+    first_free_node = node;
+}
+
+void DynamicAabbTree::InsertLeaf(int leaf) {
+    if (root == -1) {
+        root = leaf;
+        nodes[root].parent = -1;
+        return;
+    }
+
+    // Find the best sibling for the leaf, going down the cheapest branch (surface area heuristic, with perimeters in 2D).
+    const Aabb leaf_box = nodes[leaf].box;
+    int sibling = root;
+    while (!IsLeaf(sibling)) {
+        const Node& node = nodes[sibling];
+        const float perimeter = Perimeter(node.box);
+        const float combined_perimeter = Perimeter(Union(node.box, leaf_box));
+
+        // Cost of making a new parent for this node and the leaf.
+        const float cost = 2.0f * combined_perimeter;
+        // Minimum cost of pushing the leaf further down: every ancestor grows.
+        const float inheritance_cost = 2.0f * (combined_perimeter - perimeter);
+
+        float child_costs[2];
+        const int children[2] = {node.child1, node.child2};
+        for (int i = 0; i < 2; i++) {
+            const Node& child = nodes[children[i]];
+            const float child_perimeter = Perimeter(Union(leaf_box, child.box));
+            child_costs[i] = (IsLeaf(children[i]) ? child_perimeter : child_perimeter - Perimeter(child.box)) + inheritance_cost;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1]) {
+            break;
+        }
+        sibling = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+
+    // Make a new parent for the sibling and the leaf.
+    const int old_parent = nodes[sibling].parent;
+    const int new_parent = AllocateNode();
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].box = Union(leaf_box, nodes[sibling].box);
+    nodes[new_parent].height = nodes[sibling].height + 1;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+
+    if (old_parent != -1) {
+        if (nodes[old_parent].child1 == sibling) {
+            nodes[old_parent].child1 = new_parent;
+        } else {
+            nodes[old_parent].child2 = new_parent;
+        }
+    } else {
+        root = new_parent;
+    }
+
+    Refit(nodes[leaf].parent);
+}
+
+void DynamicAabbTree::RemoveLeaf(int leaf) {
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+
+    // The sibling takes the place of the parent.
+    const int parent = nodes[leaf].parent;
+    const int grand_parent = nodes[parent].parent;
+    const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    FreeNode(parent);
+
+    if (grand_parent == -1) {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        return;
+    }
+    if (nodes[grand_parent].child1 == parent) {
+        nodes[grand_parent].child1 = sibling;
+    } else {
+        nodes[grand_parent].child2 = sibling;
+    }
+    nodes[sibling].parent = grand_parent;
+    Refit(grand_parent);
+}
+
+void DynamicAabbTree::Refit(int node) {
+    while (node != -1) {
+        node = Balance(node);
+        Node& inner_node = nodes[node];
+        const Node& child1 = nodes[inner_node.child1];
+        const Node& child2 = nodes[inner_node.child2];
+        inner_node.height = 1 + std::max(child1.height, child2.height);
+        inner_node.box = Union(child1.box, child2.box);
+        node = inner_node.parent;
+    }
+}
+
+int DynamicAabbTree::Balance(int a) {
+    if (IsLeaf(a) || nodes[a].height < 2) {
+        return a;
+    }
+
+    const int b = nodes[a].child1;
+    const int c = nodes[a].child2;
+    const int balance = nodes[c].height - nodes[b].height;
+    if (balance >= -1 && balance <= 1) {
+        return a;
+    }
+
+    // Rotate the taller child (up) into the place of a, a becomes its child.
+    const int up = balance > 1 ? c : b;
+    const int other = balance > 1 ? b : c;
+    const int up_child1 = nodes[up].child1;
+    const int up_child2 = nodes[up].child2;
+
+    nodes[up].child1 = a;
+    nodes[up].parent = nodes[a].parent;
+    nodes[a].parent = up;
+    if (nodes[up].parent != -1) {
+        if (nodes[nodes[up].parent].child1 == a) {
+            nodes[nodes[up].parent].child1 = up;
+        } else {
+            nodes[nodes[up].parent].child2 = up;
+        }
+    } else {
+        root = up;
+    }
+
+    // The taller grandchild stays under up, the shorter one goes to a, in the place of up.
+    const bool is_child1_taller = nodes[up_child1].height > nodes[up_child2].height;
+    const int kept = is_child1_taller ? up_child1 : up_child2;
+    const int moved = is_child1_taller ? up_child2 : up_child1;
+    nodes[up].child2 = kept;
+    if (balance > 1) {
+        nodes[a].child2 = moved;
+    } else {
+        nodes[a].child1 = moved;
+    }
+    nodes[moved].parent = a;
+
+    nodes[a].box = Union(nodes[other].box, nodes[moved].box);
+    nodes[a].height = 1 + std::max(nodes[other].height, nodes[moved].height);
+    nodes[up].box = Union(nodes[a].box, nodes[kept].box);
+    nodes[up].height = 1 + std::max(nodes[a].height, nodes[kept].height);
+    return up;
+}
+
+void DynamicAabbTree::Update(const Aabb* new_boxes, const CollisionFilter* box_filters, const int* ids, int count, float width, float height) {
+    (void)width;
+    (void)height;
+
+    frame++;
+    boxes.assign(new_boxes, new_boxes + count);
+    filters.assign(box_filters, box_filters + count);
+    for (int i = 0; i < count; i++) {
+        const int id = ids[i];
+        if (static_cast<size_t>(id) >= id_leaves.size()) {
+            id_leaves.resize(id + 1, -1);
+            id_box_indices.resize(id + 1, -1);
+            id_frames.resize(id + 1, 0);
+        }
+        id_box_indices[id] = i;
+        id_frames[id] = frame;
+    }
+
+    // Drop the leaves of the boxes that are gone.
+    size_t num_kept_leaf_ids = 0;
+    for (auto id : leaf_ids) {
+        if (id_frames[id] == frame) {
+            leaf_ids[num_kept_leaf_ids++] = id;
+        } else {
+            RemoveLeaf(id_leaves[id]);
+            FreeNode(id_leaves[id]);
+            id_leaves[id] = -1;
+        }
+    }
+    leaf_ids.resize(num_kept_leaf_ids);
+
+    // Insert the new boxes, and move the boxes that left their fat box.
+    for (int i = 0; i < count; i++) {
+        const int id = ids[i];
+        int leaf = id_leaves[id];
+        if (leaf == -1) {
+            leaf = AllocateNode();
+            nodes[leaf].id = id;
+            nodes[leaf].box = Fatten(boxes[i]);
+            InsertLeaf(leaf);
+            id_leaves[id] = leaf;
+            leaf_ids.push_back(id);
+        } else if (!Contains(nodes[leaf].box, boxes[i])) {
+            RemoveLeaf(leaf);
+            nodes[leaf].box = Fatten(boxes[i]);
+            InsertLeaf(leaf);
+        }
+    }
+}
+
+void DynamicAabbTree::FindCandidatePairs(std::vector<std::pair<int, int>>& pairs) {
+    if (root == -1) {
+        return;
+    }
+    // Traverse the tree against itself: a pair of subtrees is only opened when their boxes overlap,
+    // and a subtree paired with itself opens into the pairs of its children, so every leaf pair is met once.
+    node_pairs.clear();
+    node_pairs.emplace_back(root, root);
+    while (!node_pairs.empty()) {
+        const int a = node_pairs.back().first;
+        const int b = node_pairs.back().second;
+        node_pairs.pop_back();
+
+        if (a == b) {
+            if (!IsLeaf(a)) {
+                node_pairs.emplace_back(nodes[a].child1, nodes[a].child1);
+                node_pairs.emplace_back(nodes[a].child2, nodes[a].child2);
+                node_pairs.emplace_back(nodes[a].child1, nodes[a].child2);
+            }
+            continue;
+        }
+        if (!Overlaps(nodes[a].box, nodes[b].box)) {
+            continue;
+        }
+        if (IsLeaf(a) && IsLeaf(b)) {
+            // The fat boxes overlap, keep the pair if the boxes themselves do.
+            const int box_a = id_box_indices[nodes[a].id];
+            const int box_b = id_box_indices[nodes[b].id];
+            if (CanCollide(filters[box_a], filters[box_b]) && Overlaps(boxes[box_a], boxes[box_b])) {
+                pairs.emplace_back(std::min(box_a, box_b), std::max(box_a, box_b));
+            }
+            continue;
+        }
+        // Open the taller subtree.
+        if (IsLeaf(b) || (!IsLeaf(a) && nodes[a].height >= nodes[b].height)) {
+            node_pairs.emplace_back(nodes[a].child1, b);
+            node_pairs.emplace_back(nodes[a].child2, b);
+        } else {
+            node_pairs.emplace_back(a, nodes[b].child1);
+            node_pairs.emplace_back(a, nodes[b].child2);
+        }
+    }
+}
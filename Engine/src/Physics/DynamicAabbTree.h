@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Broadphase.h"
+
+// Distance in pixels the tree boxes are grown by on each side, so a box that moves a little
+// stays inside its tree box and the tree is left untouched.
+const float AABB_TREE_MARGIN = 8.0f;
+
+// Dynamic bounding volume tree broadphase: every box is a leaf of a balanced binary tree,
+// whose inner nodes bound their children. The tree is kept from one frame to the next, and a box only
+// moves in the tree when it leaves its fat leaf box. The pairs come from one traversal of the tree against itself.
+// Suits sparse scenes and boxes of very different sizes (e.g. a few huge carriers).
+class DynamicAabbTree : public IBroadphase
+{
+private:
+    struct Node
+    {
+        // Fat box of a leaf, or the union of the children of an inner node.
+        Aabb box;
+        int parent = -1;
+        // Children of an inner node, -1 for a leaf.
+        int child1 = -1;
+        int child2 = -1;
+        // 0 for a leaf.
+        int height = 0;
+        // Id of the box of a leaf.
+        int id = -1;
+        // Next node of the free list.
+        int next = -1;
+    };
+    std::vector<Node> nodes;
+    int root = -1;
+    int first_free_node = -1;
+
+    // Leaf of every id (-1 for none).
+    // vector index = id
+    std::vector<int> id_leaves;
+    // Ids that have a leaf.
+    std::vector<int> leaf_ids;
+
+    // Index of every id in the boxes of the last Update(), valid if id_frames[id] == frame.
+    // vector index = id
+    std::vector<int> id_box_indices;
+    std::vector<uint32_t> id_frames;
+    uint32_t frame = 0;
+
+    // Copy of the boxes of the last Update(), and of their filters.
+    std::vector<Aabb> boxes;
+    std::vector<CollisionFilter> filters;
+
+    // Scratch stack of the pairs of subtrees still to test against each other.
+    std::vector<std::pair<int, int>> node_pairs;
+
+    int AllocateNode();
+    void FreeNode(int node);
+    bool IsLeaf(int node) const { return nodes[node].child1 == -1; }
+
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    // Walk from node up to the root, rebalancing and refitting the boxes on the way.
+    void Refit(int node);
+    // Rotate the tree at node if one child is more than one level taller than the other.
+    // Returns the node now at the place of node.
+    int Balance(int node);
+
+public:
+    DynamicAabbTree() = default;
+
+    void Update(const Aabb* boxes, const CollisionFilter* box_filters, const int* ids, int count, float width, float height) override;
+
+    // The pairs of boxes that overlap and can collide, not sorted.
+    void FindCandidatePairs(std::vector<std::pair<int, int>>& pairs) override;
+
+    const char* GetName() const override { return "tree"; }
+
+    int GetHeight() const { return root == -1 ? 0 : nodes[root].height; }
+};
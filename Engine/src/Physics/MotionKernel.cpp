@@ -0,0 +1,144 @@
+#include "MotionKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__)
+#define MOTION_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts AVX2 intrinsics in any function, GCC and Clang must be told to compile the function for AVX2.
+#if defined(MOTION_KERNEL_X86) && !defined(_MSC_VER)
+#define MOTION_KERNEL_AVX2 __attribute__((target("avx2")))
+#else
+#define MOTION_KERNEL_AVX2
+#endif
+
+static bool IsOutOfMap(float x, float y, float map_width, float map_height) {
+    return x < 0 || x > map_width || y < 0 || y > map_height;
+}
+
+size_t IntegrateMotionScalar(const MotionArrays& motion, size_t count, float delta_time, float map_width, float map_height, int* out_of_map_indices) {
+    size_t num_out_of_map = 0;
+    for (size_t i = 0; i < count; i++) {
+        motion.position_x[i] += motion.velocity_x[i] * delta_time;
+        motion.position_y[i] += motion.velocity_y[i] * delta_time;
+        if (IsOutOfMap(motion.position_x[i], motion.position_y[i], map_width, map_height)) {
+            out_of_map_indices[num_out_of_map++] = static_cast<int>(i);
+        }
+    }
+    return num_out_of_map;
+}
+
+#ifdef MOTION_KERNEL_X86
+// Appends the index of every set bit of a lane mask.
+static size_t AppendLaneIndices(int lane_mask, size_t first_index, int* out_of_map_indices, size_t num_out_of_map) {
+    for (int lane = 0; lane_mask != 0; lane++, lane_mask >>= 1) {
+        if (lane_mask & 1) {
+            out_of_map_indices[num_out_of_map++] = static_cast<int>(first_index) + lane;
+        }
+    }
+    return num_out_of_map;
+}
+
+static size_t IntegrateMotionSse2(const MotionArrays& motion, size_t count, float delta_time, float map_width, float map_height, int* out_of_map_indices) {
+    const __m128 dt = _mm_set1_ps(delta_time);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 width = _mm_set1_ps(map_width);
+    const __m128 height = _mm_set1_ps(map_height);
+
+    size_t num_out_of_map = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_add_ps(_mm_loadu_ps(motion.position_x + i), _mm_mul_ps(_mm_loadu_ps(motion.velocity_x + i), dt));
+        const __m128 y = _mm_add_ps(_mm_loadu_ps(motion.position_y + i), _mm_mul_ps(_mm_loadu_ps(motion.velocity_y + i), dt));
+        _mm_storeu_ps(motion.position_x + i, x);
+        _mm_storeu_ps(motion.position_y + i, y);
+
+        const __m128 is_out_of_map = _mm_or_ps(
+            _mm_or_ps(_mm_cmplt_ps(x, zero), _mm_cmpgt_ps(x, width)),
+            _mm_or_ps(_mm_cmplt_ps(y, zero), _mm_cmpgt_ps(y, height))
+        );
+        const int lane_mask = _mm_movemask_ps(is_out_of_map);
+        if (lane_mask != 0) {
+            num_out_of_map = AppendLaneIndices(lane_mask, i, out_of_map_indices, num_out_of_map);
+        }
+    }
+
+    // Finish the last entities one at a time.
+    MotionArrays tail = { motion.position_x + i, motion.position_y + i, motion.velocity_x + i, motion.velocity_y + i };
+    const size_t num_tail_out_of_map = IntegrateMotionScalar(tail, count - i, delta_time, map_width, map_height, out_of_map_indices + num_out_of_map);
+    for (size_t j = 0; j < num_tail_out_of_map; j++) {
+        out_of_map_indices[num_out_of_map + j] += static_cast<int>(i);
+    }
+    return num_out_of_map + num_tail_out_of_map;
+}
+
+MOTION_KERNEL_AVX2
+static size_t IntegrateMotionAvx2(const MotionArrays& motion, size_t count, float delta_time, float map_width, float map_height, int* out_of_map_indices) {
+    const __m256 dt = _mm256_set1_ps(delta_time);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 width = _mm256_set1_ps(map_width);
+    const __m256 height = _mm256_set1_ps(map_height);
+
+    size_t num_out_of_map = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 x = _mm256_add_ps(_mm256_loadu_ps(motion.position_x + i), _mm256_mul_ps(_mm256_loadu_ps(motion.velocity_x + i), dt));
+        const __m256 y = _mm256_add_ps(_mm256_loadu_ps(motion.position_y + i), _mm256_mul_ps(_mm256_loadu_ps(motion.velocity_y + i), dt));
+        _mm256_storeu_ps(motion.position_x + i, x);
+        _mm256_storeu_ps(motion.position_y + i, y);
+
+        const __m256 is_out_of_map = _mm256_or_ps(
+            _mm256_or_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), _mm256_cmp_ps(x, width, _CMP_GT_OQ)),
+            _mm256_or_ps(_mm256_cmp_ps(y, zero, _CMP_LT_OQ), _mm256_cmp_ps(y, height, _CMP_GT_OQ))
+        );
+        const int lane_mask = _mm256_movemask_ps(is_out_of_map);
+        if (lane_mask != 0) {
+            num_out_of_map = AppendLaneIndices(lane_mask, i, out_of_map_indices, num_out_of_map);
+        }
+    }
+
+    // The last 0 to 7 entities go through the SSE2 version.
+    MotionArrays tail = { motion.position_x + i, motion.position_y + i, motion.velocity_x + i, motion.velocity_y + i };
+    const size_t num_tail_out_of_map = IntegrateMotionSse2(tail, count - i, delta_time, map_width, map_height, out_of_map_indices + num_out_of_map);
+    for (size_t j = 0; j < num_tail_out_of_map; j++) {
+        out_of_map_indices[num_out_of_map + j] += static_cast<int>(i);
+    }
+    return num_out_of_map + num_tail_out_of_map;
+}
+
+static bool IsAvx2Supported() {
+#ifdef _MSC_VER
+    // AVX2 needs the CPU feature bit, and the operating system must save the AVX registers (OSXSAVE + XCR0).
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool has_os_avx_support = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 0x6) == 0x6);
+    if (!has_os_avx_support) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+size_t IntegrateMotion(const MotionArrays& motion, size_t count, float delta_time, float map_width, float map_height, int* out_of_map_indices) {
+#ifdef MOTION_KERNEL_X86
+    // The CPU does not change while the game runs, so the check is done once.
+    static const bool is_avx2_supported = IsAvx2Supported();
+    if (is_avx2_supported) {
+        return IntegrateMotionAvx2(motion, count, delta_time, map_width, map_height, out_of_map_indices);
+    }
+    return IntegrateMotionSse2(motion, count, delta_time, map_width, map_height, out_of_map_indices);
+#else
+    return IntegrateMotionScalar(motion, count, delta_time, map_width, map_height, out_of_map_indices);
+#endif
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+// Motion data of a batch of entities, stored as separate float arrays (structure of arrays),
+// so the integration can process several entities per instruction.
+// The transform and rigid body components are stored as structures, so MovementSystem integrates them in place:
+// copying them into these arrays and back costs more than the kernel saves (see MovementBenchmark).
+struct MotionArrays
+{
+    float* position_x;
+    float* position_y;
+    const float* velocity_x;
+    const float* velocity_y;
+};
+
+// Moves count positions by velocity * delta_time, and writes the indices of the entities that end up
+// outside of the map (x < 0, x > map_width, y < 0 or y > map_height) to out_of_map_indices, in increasing order.
+// out_of_map_indices must have room for count indices. Returns the number of indices written.
+// Uses AVX2 (8 entities at a time) when the CPU supports it, SSE2 (4 at a time) otherwise, and plain C++ on other platforms.
+size_t IntegrateMotion(const MotionArrays& motion, size_t count, float delta_time, float map_width, float map_height, int* out_of_map_indices);
+
+// Reference version of IntegrateMotion(), one entity at a time.
+size_t IntegrateMotionScalar(const MotionArrays& motion, size_t count, float delta_time, float map_width, float map_height, int* out_of_map_indices);
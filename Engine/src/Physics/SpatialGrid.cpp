@@ -0,0 +1,126 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+int SpatialGrid::GetColumn(float x) const {
+    // Written so that NaN also ends up in the first column.
+    if (!(x > 0.0f)) {
+        return 0;
+    }
+    const float column = x * inverse_cell_size;
+    return column >= num_columns - 1 ? num_columns - 1 : static_cast<int>(column);
+}
+
+int SpatialGrid::GetRow(float y) const {
+    if (!(y > 0.0f)) {
+        return 0;
+    }
+    const float row = y * inverse_cell_size;
+    return row >= num_rows - 1 ? num_rows - 1 : static_cast<int>(row);
+}
+
+void SpatialGrid::Update(const Aabb* boxes, const CollisionFilter* box_filters, const int* ids, int count, float width, float height) {
+    (void)ids;
+    filters.assign(box_filters, box_filters + count);
+
+    // Cells about as big as the boxes: smaller cells list a box many times, bigger ones make more candidates.
+    float total_size = 0.0f;
+    for (int i = 0; i < count; i++) {
+        total_size += std::max(boxes[i].max_x - boxes[i].min_x, boxes[i].max_y - boxes[i].min_y);
+    }
+    cell_size = SPATIAL_GRID_MIN_CELL_SIZE;
+    if (count > 0 && total_size / count > cell_size) {
+        cell_size = total_size / count;
+    }
+    width = std::max(width, 1.0f);
+    height = std::max(height, 1.0f);
+    while (std::ceil(width / cell_size) * std::ceil(height / cell_size) > SPATIAL_GRID_MAX_CELLS) {
+        cell_size *= 2.0f;
+    }
+    inverse_cell_size = 1.0f / cell_size;
+    num_columns = static_cast<int>(std::ceil(width / cell_size));
+    num_rows = static_cast<int>(std::ceil(height / cell_size));
+    const int num_cells = num_columns * num_rows;
+
+    // Counting sort of the boxes by cell: count the boxes of every cell,
+    // turn the counts into the end of every cell, then fill the cells back to front.
+    cell_ranges.resize(count);
+    cell_starts.assign(num_cells + 1, 0);
+    int num_cell_boxes = 0;
+    for (int i = 0; i < count; i++) {
+        CellRange& range = cell_ranges[i];
+        range.min_column = GetColumn(boxes[i].min_x);
+        range.min_row = GetRow(boxes[i].min_y);
+        range.max_column = std::max(GetColumn(boxes[i].max_x), range.min_column);
+        range.max_row = std::max(GetRow(boxes[i].max_y), range.min_row);
+        for (int row = range.min_row; row <= range.max_row; row++) {
+            for (int column = range.min_column; column <= range.max_column; column++) {
+                cell_starts[row * num_columns + column]++;
+            }
+        }
+        num_cell_boxes += (range.max_column - range.min_column + 1) * (range.max_row - range.min_row + 1);
+    }
+    for (int cell = 1; cell <= num_cells; cell++) {
+        cell_starts[cell] += cell_starts[cell - 1];
+    }
+
+    cell_boxes.resize(num_cell_boxes);
+    for (int i = count - 1; i >= 0; i--) {
+        const CellRange& range = cell_ranges[i];
+        for (int row = range.min_row; row <= range.max_row; row++) {
+            for (int column = range.min_column; column <= range.max_column; column++) {
+                cell_boxes[--cell_starts[row * num_columns + column]] = i;
+            }
+        }
+    }
+}
+
+void SpatialGrid::FindCandidates(const Aabb& box, const CollisionFilter& filter, std::vector<int>& box_indices) const {
+    const int min_column = GetColumn(box.min_x);
+    const int min_row = GetRow(box.min_y);
+    const int max_column = std::max(GetColumn(box.max_x), min_column);
+    const int max_row = std::max(GetRow(box.max_y), min_row);
+    for (int row = min_row; row <= max_row; row++) {
+        for (int column = min_column; column <= max_column; column++) {
+            const int cell = row * num_columns + column;
+            for (int i = cell_starts[cell]; i < cell_starts[cell + 1]; i++) {
+                const int other = cell_boxes[i];
+                if (!CanCollide(filter, filters[other])) {
+                    continue;
+                }
+                // Same rule as for the pairs: only the first cell shared with the box reports it.
+                const CellRange& range = cell_ranges[other];
+                if (std::max(range.min_column, min_column) == column && std::max(range.min_row, min_row) == row) {
+                    box_indices.push_back(other);
+                }
+            }
+        }
+    }
+}
+
+void SpatialGrid::FindCandidatePairs(std::vector<std::pair<int, int>>& pairs) {
+    for (int row = 0; row < num_rows; row++) {
+        for (int column = 0; column < num_columns; column++) {
+            const int cell = row * num_columns + column;
+            const int first = cell_starts[cell];
+            const int last = cell_starts[cell + 1];
+            for (int i = first; i < last; i++) {
+                const int a = cell_boxes[i];
+                const CellRange& a_range = cell_ranges[a];
+                const CollisionFilter a_filter = filters[a];
+                for (int j = i + 1; j < last; j++) {
+                    const int b = cell_boxes[j];
+                    if (!CanCollide(a_filter, filters[b])) {
+                        continue;
+                    }
+                    const CellRange& b_range = cell_ranges[b];
+                    // Two boxes may share several cells, the pair is only reported by the first one.
+                    if (std::max(a_range.min_column, b_range.min_column) == column && std::max(a_range.min_row, b_range.min_row) == row) {
+                        pairs.emplace_back(a, b);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "Broadphase.h"
+
+// Smallest cell size of the grid, in pixels.
+const float SPATIAL_GRID_MIN_CELL_SIZE = 32.0f;
+
+// Largest number of cells of the grid: the cells grow when the world is too big for it.
+const int SPATIAL_GRID_MAX_CELLS = 1 << 16;
+
+// Uniform grid broadphase over a world of width x height pixels.
+// The grid is rebuilt from packed boxes every frame: each box is listed in every cell it covers,
+// and only boxes that share a cell become candidate pairs. Boxes outside of the world are
+// clamped to the border cells, so they are still found, only less efficiently.
+// Suits dense scenes of similar boxes, such as bullet clouds.
+class SpatialGrid : public IBroadphase
+{
+private:
+    float cell_size = SPATIAL_GRID_MIN_CELL_SIZE;
+    float inverse_cell_size = 1.0f / SPATIAL_GRID_MIN_CELL_SIZE;
+    int num_columns = 1;
+    int num_rows = 1;
+
+    // Range of cells covered by every box.
+    struct CellRange
+    {
+        int min_column;
+        int min_row;
+        int max_column;
+        int max_row;
+    };
+    std::vector<CellRange> cell_ranges;
+    std::vector<CollisionFilter> filters;
+
+    // Boxes of every cell, stored back to back: the boxes of cell c are
+    // cell_boxes[cell_starts[c]] to cell_boxes[cell_starts[c + 1] - 1], in increasing order.
+    std::vector<int> cell_starts;
+    std::vector<int> cell_boxes;
+
+    int GetColumn(float x) const;
+    int GetRow(float y) const;
+
+public:
+    SpatialGrid() = default;
+
+    // Rebuild the grid from the boxes, the ids are not needed.
+    // The cell size follows the average box size, so most boxes cover one to four cells.
+    void Update(const Aabb* boxes, const CollisionFilter* box_filters, const int* ids, int count, float width, float height) override;
+
+    // The pairs of boxes that share at least one cell, not sorted.
+    void FindCandidatePairs(std::vector<std::pair<int, int>>& pairs) override;
+
+    // Append the boxes of the last Update() that share a cell with box and can collide with filter, each once.
+    // Lets a grid of boxes that do not move be built once and queried with the moving boxes.
+    void FindCandidates(const Aabb& box, const CollisionFilter& filter, std::vector<int>& box_indices) const;
+
+    const char* GetName() const override { return "grid"; }
+
+    float GetCellSize() const { return cell_size; }
+    int GetNumCells() const { return num_columns * num_rows; }
+};
@@ -0,0 +1,81 @@
+#include "SweepAndPrune.h"
+
+#include <algorithm>
+
+void SweepAndPrune::Update(const Aabb* boxes, const CollisionFilter* filters, const int* ids, int count, float width, float height) {
+    (void)width;
+    (void)height;
+
+    frame++;
+    for (int i = 0; i < count; i++) {
+        const int id = ids[i];
+        if (static_cast<size_t>(id) >= id_box_indices.size()) {
+            id_box_indices.resize(id + 1, -1);
+            id_frames.resize(id + 1, 0);
+            id_entries.resize(id + 1, false);
+        }
+        id_box_indices[id] = i;
+        id_frames[id] = frame;
+    }
+
+    // Refresh the boxes that are still there, in place so the list stays almost sorted.
+    size_t num_kept_entries = 0;
+    for (auto& entry : entries) {
+        if (id_frames[entry.id] != frame) {
+            id_entries[entry.id] = false;
+            continue;
+        }
+        entry.box_index = id_box_indices[entry.id];
+        entry.box = boxes[entry.box_index];
+        entry.filter = filters[entry.box_index];
+        entries[num_kept_entries++] = entry;
+    }
+    entries.resize(num_kept_entries);
+
+    // Insertion sort: fast on a list that is almost sorted, which is the case when the boxes move a little.
+    for (size_t i = 1; i < entries.size(); i++) {
+        if (entries[i - 1].box.min_x <= entries[i].box.min_x) {
+            continue;
+        }
+        const Entry entry = entries[i];
+        size_t j = i;
+        while (j > 0 && entries[j - 1].box.min_x > entry.box.min_x) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+
+    // The new boxes are sorted on their own and merged in, so a burst of new boxes does not degrade the insertion sort.
+    new_entries.clear();
+    for (int i = 0; i < count; i++) {
+        const int id = ids[i];
+        if (!id_entries[id]) {
+            id_entries[id] = true;
+            new_entries.push_back({boxes[i], filters[i], id, i});
+        }
+    }
+    if (!new_entries.empty()) {
+        const auto is_before = [](const Entry& a, const Entry& b) { return a.box.min_x < b.box.min_x; };
+        std::sort(new_entries.begin(), new_entries.end(), is_before);
+        merged_entries.resize(entries.size() + new_entries.size());
+        std::merge(entries.begin(), entries.end(), new_entries.begin(), new_entries.end(), merged_entries.begin(), is_before);
+        entries.swap(merged_entries);
+    }
+}
+
+void SweepAndPrune::FindCandidatePairs(std::vector<std::pair<int, int>>& pairs) {
+    const size_t count = entries.size();
+    for (size_t i = 0; i < count; i++) {
+        const Aabb& box = entries[i].box;
+        const CollisionFilter& filter = entries[i].filter;
+        for (size_t j = i + 1; j < count && entries[j].box.min_x <= box.max_x; j++) {
+            const Aabb& other_box = entries[j].box;
+            if (CanCollide(filter, entries[j].filter) && box.min_y <= other_box.max_y && box.max_y >= other_box.min_y) {
+                const int a = entries[i].box_index;
+                const int b = entries[j].box_index;
+                pairs.emplace_back(std::min(a, b), std::max(a, b));
+            }
+        }
+    }
+}
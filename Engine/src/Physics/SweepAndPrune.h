@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Broadphase.h"
+
+// Sort and sweep broadphase along the x axis: the boxes are kept sorted by their left side from one frame
+// to the next, so the order is repaired with an insertion sort that only moves the boxes that overtook others.
+// The sweep then pairs each box with the following ones until their left side passes its right side.
+// Suits dense scenes where the boxes move a little every frame and are spread along x.
+class SweepAndPrune : public IBroadphase
+{
+private:
+    struct Entry
+    {
+        Aabb box;
+        CollisionFilter filter;
+        int id;
+        int box_index;
+    };
+
+    // Boxes sorted by min_x.
+    std::vector<Entry> entries;
+    // New entries of the current frame, and scratch list to merge them into entries.
+    std::vector<Entry> new_entries;
+    std::vector<Entry> merged_entries;
+
+    // Index of every id in the boxes of the last Update(), valid if id_frames[id] == frame.
+    // vector index = id
+    std::vector<int> id_box_indices;
+    std::vector<uint32_t> id_frames;
+    // True if the id has an entry.
+    std::vector<bool> id_entries;
+    uint32_t frame = 0;
+
+public:
+    SweepAndPrune() = default;
+
+    void Update(const Aabb* boxes, const CollisionFilter* filters, const int* ids, int count, float width, float height) override;
+
+    // The pairs of boxes that can collide and overlap on both axes, not sorted.
+    void FindCandidatePairs(std::vector<std::pair<int, int>>& pairs) override;
+
+    const char* GetName() const override { return "sweep_and_prune"; }
+};
@@ -1,29 +1,35 @@
 #pragma once
 
 #include "../ECS/ECS.h"
+#include "../JobSystem/JobSystem.h"
 #include "../Components/AnimationComponent.h"
 #include "../Components/SpriteComponent.h"
 
+// Minimum number of entities animated by one job.
+const size_t ANIMATION_MIN_ENTITIES_PER_JOB = 1024;
+
 class AnimationSystem : public System
 {
 public:
     AnimationSystem() {
         RequireComponent<SpriteComponent>();
         RequireComponent<AnimationComponent>();
+        WritesComponent<SpriteComponent>();
+        WritesComponent<AnimationComponent>();
     }
 
-    void Update() {
-        for (auto entity : GetSystemEntities()) {
-            auto& animation = entity.GetComponent<AnimationComponent>();
-            auto& sprite = entity.GetComponent<SpriteComponent>();
+    void Update(std::unique_ptr<JobSystem>& job_system) {
+        const auto entities = GetSystemEntities();
+        const size_t ticks = SDL_GetTicks();
 
-            animation.current_frame = fmod(((SDL_GetTicks() - (size_t) animation.start_time) * (animation.frame_speed_rate / 1000.0)), animation.num_frames);
-            sprite.src_rect.x = animation.current_frame * sprite.width;
+        job_system->ParallelFor(entities.size(), ANIMATION_MIN_ENTITIES_PER_JOB, [&](size_t begin, size_t end, unsigned int thread_index) {
+            for (size_t i = begin; i < end; i++) {
+                auto& animation = entities[i].GetComponent<AnimationComponent>();
+                auto& sprite = entities[i].GetComponent<SpriteComponent>();
 
-            // TODO:
-            // change the current frame.
-            // change the src rectangle of the sprite.
-            // ...
-        }
+                animation.current_frame = fmod(((ticks - (size_t) animation.start_time) * (animation.frame_speed_rate / 1000.0)), animation.num_frames);
+                sprite.src_rect.x = animation.current_frame * sprite.width;
+            }
+        });
     }
 };
@@ -17,7 +17,7 @@ public:
 
     void Update(SDL_Rect& camera) {
         for (auto entity : GetSystemEntities()) {
-            auto transform = entity.GetComponent<TransformComponent>();
+            const auto& transform = entity.ReadComponent<TransformComponent>();
 
             if (transform.position.x + (camera.w / 2) < Game::map_width) {
                 camera.x = transform.position.x - (Game::window_width / 2);
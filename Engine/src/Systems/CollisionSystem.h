@@ -1,22 +1,156 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "../ECS/ECS.h"
 #include "../EventBus/EventBus.h"
 #include "..\Events\CollisionEvent.h"
+#include "../Physics/AabbKernel.h"
+#include "../Physics/Broadphase.h"
+#include "../Physics/BroadphaseBenchmark.h"
+#include "../Physics/SpatialGrid.h"
 
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
 
+// Number of frames a broadphase recording keeps at most (10 seconds at 60 fps).
+const int BROADPHASE_RECORDING_MAX_FRAMES = 600;
 
 class CollisionSystem : public System
 {
+private:
+    // Scratch lists of the entities and boxes of the colliders of the current frame, packed so the pairs are tested
+    // in batches without fetching the components again. They keep their capacity between frames.
+    std::vector<Entity> collider_entities;
+    PackedAabbs collider_boxes;
+
+    // Boxes, collision layers and entity ids of the moving colliders of the current frame,
+    // and the index of every one of them in the colliders of the frame.
+    std::vector<Aabb> boxes;
+    std::vector<CollisionFilter> box_filters;
+    std::vector<int> box_ids;
+    std::vector<int> box_collider_indices;
+
+    // Only the candidate pairs of the broadphase are tested against each other. The level picks the broadphase.
+    // It only sees the moving colliders.
+    std::unique_ptr<IBroadphase> broadphase = std::make_unique<SpatialGrid>();
+    std::vector<std::pair<int, int>> candidate_pairs;
+    // Colliding pairs of the last Update(), as indices into collider_entities, until their events are emitted.
+    std::vector<std::pair<int, int>> colliding_pairs;
+
+    // Colliders that do not move (no rigid body, or marked static) are kept in their own grid, which is only
+    // rebuilt when one of them is added, removed or changed, e.g. once at level load. Every moving collider
+    // is looked up in it, and static colliders are never tested against each other.
+    SpatialGrid static_grid;
+    std::vector<Entity> static_entities;
+    std::vector<Aabb> static_boxes;
+    std::vector<CollisionFilter> static_filters;
+    std::vector<int> static_ids;
+    float static_grid_width = 0.0f;
+    float static_grid_height = 0.0f;
+    // Index of every collider of the static grid in the colliders of the frame, refreshed every frame.
+    std::vector<int> static_collider_indices;
+    // Index of every entity in the static grid, or -1 if it is not in it.
+    // vector index = entity id
+    std::vector<int> entity_static_indices;
+    // Static colliders of the current frame, to rebuild the static grid from when it changed.
+    std::vector<Entity> new_static_entities;
+    std::vector<Aabb> new_static_boxes;
+    std::vector<CollisionFilter> new_static_filters;
+    std::vector<int> new_static_ids;
+    std::vector<int> new_static_collider_indices;
+    std::vector<int> static_candidates;
+
+    // Whether the collider at collider_index is the static collider of the entity, with the same box and filter,
+    // as when the static grid was built. Records its collider index if it is.
+    bool IsInStaticGrid(Entity entity, const Aabb& box, const CollisionFilter& filter, int collider_index) {
+        const auto entity_id = entity.GetId();
+        if (static_cast<size_t>(entity_id) >= entity_static_indices.size()) {
+            return false;
+        }
+        const int static_index = entity_static_indices[entity_id];
+        if (static_index == -1 || static_entities[static_index] != entity) {
+            return false;
+        }
+        const Aabb& static_box = static_boxes[static_index];
+        const CollisionFilter& static_filter = static_filters[static_index];
+        if (static_box.min_x != box.min_x || static_box.min_y != box.min_y || static_box.max_x != box.max_x || static_box.max_y != box.max_y ||
+            static_filter.layer != filter.layer || static_filter.mask != filter.mask) {
+            return false;
+        }
+        static_collider_indices[static_index] = collider_index;
+        return true;
+    }
+
+    void RebuildStaticGrid(float width, float height) {
+        for (int static_id : static_ids) {
+            entity_static_indices[static_id] = -1;
+        }
+        static_entities.swap(new_static_entities);
+        static_boxes.swap(new_static_boxes);
+        static_filters.swap(new_static_filters);
+        static_ids.swap(new_static_ids);
+        static_collider_indices.swap(new_static_collider_indices);
+        for (size_t i = 0; i < static_ids.size(); i++) {
+            const int static_id = static_ids[i];
+            if (static_cast<size_t>(static_id) >= entity_static_indices.size()) {
+                entity_static_indices.resize(static_id + 1, -1);
+            }
+            entity_static_indices[static_id] = static_cast<int>(i);
+        }
+        static_grid.Update(static_boxes.data(), static_filters.data(), static_ids.data(), static_cast<int>(static_boxes.size()), width, height);
+        static_grid_width = width;
+        static_grid_height = height;
+        Logger::Log("Static collider grid rebuilt with " + std::to_string(static_boxes.size()) + " colliders.");
+    }
+
+    // Boxes of the last frames, to compare the broadphases on the current level.
+    bool is_recording = false;
+    BroadphaseRecording recording;
+
 public:
     CollisionSystem() {
         RequireComponent<TransformComponent>();
         RequireComponent<BoxColliderComponent>();
     }
 
-    static bool intersect(TransformComponent& a_tc, BoxColliderComponent& a_bc, TransformComponent& b_tc, BoxColliderComponent& b_bc) {
+    void SetBroadphase(std::unique_ptr<IBroadphase> new_broadphase) {
+        broadphase = std::move(new_broadphase);
+        Logger::Log("Collisions use the " + std::string(broadphase->GetName()) + " broadphase.");
+    }
+
+    const IBroadphase& GetBroadphase() const {
+        return *broadphase;
+    }
+
+    // Start recording the moving collider boxes, or stop and replay them through every broadphase,
+    // logging the pairs they find and the time they take.
+    void ToggleBroadphaseRecording() {
+        if (!is_recording) {
+            recording.Clear();
+            is_recording = true;
+            Logger::Log("Recording the collider boxes for the broadphase comparison.");
+            return;
+        }
+        is_recording = false;
+        Logger::Log("Replaying " + std::to_string(recording.GetNumFrames()) + " frames through every broadphase:");
+        for (const auto& result : RunBroadphaseBenchmark(recording)) {
+            Logger::Log(result.name + ": " + std::to_string(result.milliseconds) + " ms, " +
+                std::to_string(result.num_candidate_pairs) + " candidate pairs, " +
+                std::to_string(result.num_overlapping_pairs) + " overlapping pairs");
+            if (result.num_mismatched_frames > 0) {
+                Logger::Err(result.name + " missed or added overlapping pairs in " + std::to_string(result.num_mismatched_frames) + " frames");
+            }
+        }
+        recording.Clear();
+    }
+
+    static bool intersect(const TransformComponent& a_tc, const BoxColliderComponent& a_bc, const TransformComponent& b_tc, const BoxColliderComponent& b_bc) {
         return (
             a_tc.position.x + a_bc.offset.x <= b_tc.position.x + b_bc.offset.x + b_bc.width &&
             a_tc.position.x + a_bc.offset.x + a_bc.width >= b_tc.position.x + b_bc.offset.x &&
@@ -25,25 +159,94 @@ public:
             );
     }
 
-    void Update(std::unique_ptr<EventBus>& event_bus) {
-        auto entities = GetSystemEntities();
-        for (auto i = entities.begin(); i != entities.end(); i++) {
-            Entity a = *i;
-            auto& a_tc = a.GetComponent<TransformComponent>();
-            auto& a_bc = a.GetComponent<BoxColliderComponent>();
-            for (auto j = i; j != entities.end(); j++) {
-                Entity b = *j;
-                if (a == b) {
-                    continue;
+    // Find the colliding pairs of the frame. Their events are emitted by EmitCollisionEvents().
+    void Update(std::unique_ptr<Registry>& registry) {
+        // Gather the colliders and their boxes once, so the pair tests do not fetch components again.
+        // The static colliders are only checked against the static grid.
+        collider_entities.clear();
+        collider_boxes.Clear();
+        boxes.clear();
+        box_filters.clear();
+        box_ids.clear();
+        box_collider_indices.clear();
+        new_static_entities.clear();
+        new_static_boxes.clear();
+        new_static_filters.clear();
+        new_static_ids.clear();
+        new_static_collider_indices.clear();
+        bool has_static_grid_changed = false;
+        registry->View<TransformComponent, BoxColliderComponent>().Each([this, &has_static_grid_changed](Entity entity, const TransformComponent& transform, const BoxColliderComponent& box_collider) {
+            const int collider_index = static_cast<int>(collider_entities.size());
+            const float min_x = transform.position.x + box_collider.offset.x;
+            const float min_y = transform.position.y + box_collider.offset.y;
+            const Aabb box = {min_x, min_y, min_x + box_collider.width, min_y + box_collider.height};
+            collider_entities.push_back(entity);
+            collider_boxes.Add(box);
+            const CollisionFilter filter = {box_collider.layer, box_collider.collision_mask};
+            if (box_collider.is_static || !entity.HasComponent<RigidBodyComponent>()) {
+                if (!has_static_grid_changed && !IsInStaticGrid(entity, box, filter, collider_index)) {
+                    has_static_grid_changed = true;
                 }
-                auto& b_tc = b.GetComponent<TransformComponent>();
-                auto& b_bc = b.GetComponent<BoxColliderComponent>();
-                bool is_collision = intersect(a_tc, a_bc, b_tc, b_bc);
-                if (is_collision) {
-                    Logger::Log("entity " + std::to_string(a.GetId()) + " collided with entity " + std::to_string(b.GetId()));
-                    event_bus->EmitEvent<CollisionEvent>(a, b);
+                new_static_entities.push_back(entity);
+                new_static_boxes.push_back(box);
+                new_static_filters.push_back(filter);
+                new_static_ids.push_back(entity.GetId());
+                new_static_collider_indices.push_back(collider_index);
+                return;
+            }
+            boxes.push_back(box);
+            box_filters.push_back(filter);
+            box_ids.push_back(entity.GetId());
+            box_collider_indices.push_back(collider_index);
+        });
+
+        const int count = static_cast<int>(boxes.size());
+        const float width = static_cast<float>(Game::map_width);
+        const float height = static_cast<float>(Game::map_height);
+        if (has_static_grid_changed || new_static_boxes.size() != static_boxes.size() || width != static_grid_width || height != static_grid_height) {
+            RebuildStaticGrid(width, height);
+        }
+        if (is_recording && recording.GetNumFrames() < BROADPHASE_RECORDING_MAX_FRAMES) {
+            recording.AddFrame(boxes.data(), box_filters.data(), box_ids.data(), count, width, height);
+        }
+
+        // Moving against moving colliders, then moving against static colliders, as indices into the colliders of the frame.
+        candidate_pairs.clear();
+        broadphase->Update(boxes.data(), box_filters.data(), box_ids.data(), count, width, height);
+        broadphase->FindCandidatePairs(candidate_pairs);
+        for (auto& candidate_pair : candidate_pairs) {
+            candidate_pair.first = box_collider_indices[candidate_pair.first];
+            candidate_pair.second = box_collider_indices[candidate_pair.second];
+        }
+        if (!static_boxes.empty()) {
+            for (int i = 0; i < count; i++) {
+                static_candidates.clear();
+                static_grid.FindCandidates(boxes[i], box_filters[i], static_candidates);
+                const int collider_index = box_collider_indices[i];
+                for (int static_index : static_candidates) {
+                    const int static_collider_index = static_collider_indices[static_index];
+                    candidate_pairs.emplace_back(std::min(collider_index, static_collider_index), std::max(collider_index, static_collider_index));
                 }
             }
         }
+        // Report the collisions in the same order as testing every pair would.
+        std::sort(candidate_pairs.begin(), candidate_pairs.end());
+
+        // Exact test of the candidates in batches (same test as intersect()), keeping their order.
+        colliding_pairs.resize(candidate_pairs.size());
+        colliding_pairs.resize(FindOverlappingPairs(collider_boxes, candidate_pairs.data(), candidate_pairs.size(), colliding_pairs.data()));
+    }
+
+    // Emit the collision events found by the last Update(). Called from the main thread once the systems are done,
+    // since the handlers (MovementSystem bounces enemies off obstacles, DamageSystem applies projectile damage)
+    // touch components that the collision system does not declare.
+    void EmitCollisionEvents(std::unique_ptr<EventBus>& event_bus) {
+        for (const auto& colliding_pair : colliding_pairs) {
+            const Entity a = collider_entities[colliding_pair.first];
+            const Entity b = collider_entities[colliding_pair.second];
+            Logger::Log("entity " + std::to_string(a.GetId()) + " collided with entity " + std::to_string(b.GetId()));
+            event_bus->EmitEvent<CollisionEvent>(a, b);
+        }
+        colliding_pairs.clear();
     }
 };
\ No newline at end of file
@@ -11,6 +11,12 @@
 
 class DamageSystem : public System
 {
+private:
+    // Resolved once, so the collision checks are integer compares.
+    const TagId player_tag = Registry::GetTagId("player");
+    const GroupId projectiles_group = Registry::GetGroupId("projectiles");
+    const GroupId enemies_group = Registry::GetGroupId("enemies");
+
 public:
     DamageSystem() {
         RequireComponent<BoxColliderComponent>();
@@ -25,28 +31,34 @@ public:
         Entity a = event.a;
         Entity b = event.b;
 
-        if (a.BelongsToGroup("projectiles") && b.HasTag("player")) {
+        // Skip events that refer to an entity that has been destroyed since.
+        if (!a.IsAlive() || !b.IsAlive()) {
+            return;
+        }
+
+        if (a.BelongsToGroup(projectiles_group) && b.HasTag(player_tag)) {
             OnProjectileHitsPlayer(a, b);
         }
-        if (b.BelongsToGroup("projectiles") && a.HasTag("player")) {
+        if (b.BelongsToGroup(projectiles_group) && a.HasTag(player_tag)) {
             OnProjectileHitsPlayer(b, a);
         }
 
-        if (a.BelongsToGroup("projectiles") && b.BelongsToGroup("enemies")) {
+        if (a.BelongsToGroup(projectiles_group) && b.BelongsToGroup(enemies_group)) {
             OnProjectileHitsEnemy(a, b);
         }
-        if (b.BelongsToGroup("projectiles") && a.BelongsToGroup("enemies")) {
+        if (b.BelongsToGroup(projectiles_group) && a.BelongsToGroup(enemies_group)) {
             OnProjectileHitsEnemy(b, a);
         }
     }
 
     void OnProjectileHitsPlayer(Entity projectile, Entity player) {
-        auto& projectile_component = projectile.GetComponent<ProjectileComponent>();
+        const auto& projectile_component = projectile.ReadComponent<ProjectileComponent>();
         if (!projectile_component.is_friendly) {
             // Reduce the health of the player by the projectile hit percent damage.
-            auto& health = player.GetComponent<HealthComponent>();
-            // Subtract the health of the player.
-            health.health_percentage -= projectile_component.hit_percent_damage;
+            auto& health = player.PatchComponent<HealthComponent>([&](HealthComponent& health) {
+                // Subtract the health of the player.
+                health.health_percentage -= projectile_component.hit_percent_damage;
+            });
             // Kills the player when health reaches zero.
             if (health.health_percentage <= 0) {
                 player.Kill();
@@ -56,12 +68,13 @@ public:
     }
 
     void OnProjectileHitsEnemy(Entity projectile, Entity enemy) {
-        auto& projectile_component = projectile.GetComponent<ProjectileComponent>();
+        const auto& projectile_component = projectile.ReadComponent<ProjectileComponent>();
         if (projectile_component.is_friendly) {
             // Reduce the health of the player by the projectile hit percent damage.
-            auto& health = enemy.GetComponent<HealthComponent>();
-            // Subtract the health of the player.
-            health.health_percentage -= projectile_component.hit_percent_damage;
+            auto& health = enemy.PatchComponent<HealthComponent>([&](HealthComponent& health) {
+                // Subtract the health of the player.
+                health.health_percentage -= projectile_component.hit_percent_damage;
+            });
             // Kills the player when health reaches zero.
             if (health.health_percentage <= 0) {
                 enemy.Kill();
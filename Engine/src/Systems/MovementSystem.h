@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 
 #include "../ECS/ECS.h"
+#include "../JobSystem/JobSystem.h"
 
 #include "../EventBus/EventBus.h"
 #include "../Events/CollisionEvent.h"
@@ -11,12 +12,50 @@
 #include "../Components/RigidBodyComponent.h"
 #include "../Components/SpriteComponent.h"
 
+// Minimum number of entities moved by one job.
+const size_t MOVEMENT_MIN_ENTITIES_PER_JOB = 1024;
+
 class MovementSystem : public System
 {
+private:
+    const TagId player_tag = Registry::GetTagId("player");
+    const GroupId enemies_group = Registry::GetGroupId("enemies");
+    const GroupId obstacles_group = Registry::GetGroupId("obstacles");
+
+    static void KeepPlayerInsideMap(Entity player) {
+        auto& transform = player.GetComponent<TransformComponent>();
+        auto& rigid_body = player.GetComponent<RigidBodyComponent>();
+        const auto& sprite = player.ReadComponent<SpriteComponent>();
+        bool is_player_at_map_boundry(
+            transform.position.x <= 0 ||
+            transform.position.x + sprite.width >= Game::map_width ||
+            transform.position.y <= 0 ||
+            transform.position.y + sprite.height >= Game::map_height
+        );
+        if (is_player_at_map_boundry) {
+            rigid_body.velocity = glm::vec2(0, 0);
+        }
+        if (transform.position.x <= 0) {
+            transform.position.x = 1;
+        }
+        if (transform.position.x + sprite.width >= Game::map_width) {
+            transform.position.x = Game::map_width - sprite.width - 1;
+        }
+        if (transform.position.y <= 0) {
+            transform.position.y = 1;
+        }
+        if (transform.position.y + sprite.height >= Game::map_height) {
+            transform.position.y = Game::map_height - sprite.height - 1;
+        }
+    }
+
 public:
     MovementSystem() {
         RequireComponent<TransformComponent>();
         RequireComponent<RigidBodyComponent>();
+        WritesComponent<TransformComponent>();
+        WritesComponent<RigidBodyComponent>();
+        ReadsComponent<SpriteComponent>();
     }
 
     void SubscribeToEvents(std::unique_ptr<EventBus>& event_bus) {
@@ -29,11 +68,11 @@ public:
         Entity a = event.a;
         Entity b = event.b;
 
-        if (a.BelongsToGroup("enemies") && b.BelongsToGroup("obstacles")) {
+        if (a.BelongsToGroup(enemies_group) && b.BelongsToGroup(obstacles_group)) {
             OnEnemyHitsObstacle(a, b);
         }
 
-        if (a.BelongsToGroup("obstacles") && b.BelongsToGroup("enemies")) {
+        if (a.BelongsToGroup(obstacles_group) && b.BelongsToGroup(enemies_group)) {
             OnEnemyHitsObstacle(b, a);
         }
     }
@@ -55,62 +94,42 @@ public:
         }
     }
 
-    void Update(double delta_time) {
-        // Loop all entities that the system is interested in...
-        for (auto entity : GetSystemEntities()) {
-            // Update entity position based on its velocity.
-            auto& transform = entity.GetComponent<TransformComponent>();
-            auto& rigid_body = entity.GetComponent<RigidBodyComponent>();
-
-            transform.position.x += rigid_body.velocity.x * delta_time;
-            transform.position.y += rigid_body.velocity.y * delta_time;
-
-            //    Logger::Log(
-            //        "entity_id = " +
-            //        std::to_string(entity.GetId()) +
-            //        " position is now (" +
-            //        std::to_string(transform.position.x) +
-            //        " , " +
-            //        std::to_string(transform.position.y) + ")"
-            //    );
-
-            if (entity.HasTag("player")) {
-                auto& sprite = entity.GetComponent<SpriteComponent>();
-                bool is_player_at_map_boundry(
-                    transform.position.x <= 0 ||
-                    transform.position.x + sprite.width >= Game::map_width ||
-                    transform.position.y <= 0 ||
-                    transform.position.y + sprite.height >= Game::map_height
-                );
-                if (is_player_at_map_boundry) {
-                    rigid_body.velocity = glm::vec2(0, 0);
+    void Update(std::unique_ptr<Registry>& registry, std::unique_ptr<JobSystem>& job_system, double delta_time) {
+        // Loop all entities that have a transform and a rigid body, straight from the packed pools,
+        // split in chunks across the job system threads. The entities are integrated right in the view loop:
+        // staging them into float arrays for the SIMD motion kernel and writing them back costs more than
+        // the kernel saves while the components are stored as structures (see MovementBenchmark).
+        auto view = registry->View<TransformComponent, RigidBodyComponent>();
+
+        Entity player = registry->GetEntityByTag(player_tag);
+        player.registry = registry.get();
+        const bool has_player = player.GetId() != -1 &&
+            player.HasComponent<TransformComponent>() && player.HasComponent<RigidBodyComponent>() && player.HasComponent<SpriteComponent>();
+        const float map_width = static_cast<float>(Game::map_width);
+        const float map_height = static_cast<float>(Game::map_height);
+
+        job_system->ParallelFor(view.GetRangeSize(), view.GetRangeSizeFor(MOVEMENT_MIN_ENTITIES_PER_JOB), [&](size_t begin, size_t end, unsigned int) {
+            // Kills are recorded in the command buffer of the thread, and applied in the next registry update.
+            CommandBuffer& commands = registry->GetCommandBuffer();
+
+            view.EachInRange(begin, end, [&](Entity entity, TransformComponent& transform, const RigidBodyComponent& rigid_body) {
+                // Update entity position based on its velocity.
+                transform.position.x += rigid_body.velocity.x * static_cast<float>(delta_time);
+                transform.position.y += rigid_body.velocity.y * static_cast<float>(delta_time);
+
+                // Kill all entities that move outside the map boundries (the player is kept inside the map instead).
+                const bool is_entity_outside_map =
+                    transform.position.x < 0 || transform.position.x > map_width ||
+                    transform.position.y < 0 || transform.position.y > map_height;
+                if (is_entity_outside_map && entity != player) {
+                    commands.KillEntity(entity);
                 }
-                if (transform.position.x <= 0) {
-                    transform.position.x = 1;
-                }
-                if (transform.position.x + sprite.width >= Game::map_width) {
-                    transform.position.x = Game::map_width - sprite.width - 1;
-                }
-                if (transform.position.y <= 0) {
-                    transform.position.y = 1;
-                }
-                if (transform.position.y + sprite.height >= Game::map_height) {
-                    transform.position.y = Game::map_height - sprite.height - 1;
-                }
-            }
-
-            bool is_entity_outside_map = (
-                transform.position.x < 0 ||
-                transform.position.x > Game::map_width ||
-                transform.position.y < 0 ||
-                transform.position.y > Game::map_height
-                );
+            });
+        });
 
-            // Kill all entities that move outside the map boundries.
-            if (is_entity_outside_map && !entity.HasTag("player")) {
-                entity.Kill();
-            }
+        // Keep the player inside the map boundries.
+        if (has_player) {
+            KeepPlayerInsideMap(player);
         }
-
     }
-};
\ No newline at end of file
+};
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <vector>
 
 #include "../ECS/ECS.h"
+#include "../Physics/CollisionLayers.h"
+#include "../Timer/TimerWheel.h"
 
 #include "../EventBus/EventBus.h"
 #include "../Events/KeyPressedEvent.h"
@@ -17,12 +20,54 @@
 
 class ProjectileEmitSystem : public System
 {
+private:
+    const TagId player_tag = Registry::GetTagId("player");
+    const GroupId projectiles_group = Registry::GetGroupId("projectiles");
+
+    // Components shared by every friendly (resp. enemy) projectile. The transform, rigid body and projectile values
+    // are set per projectile. Dead projectiles are recycled by the next emissions.
+    // The two kinds are on their own collision layers, so projectiles never collide with each other.
+    Prefab friendly_projectile_prefab;
+    Prefab enemy_projectile_prefab;
+
+    // Repeating emission timer of every enemy emitter, so each frame only visits the emitters that fire.
+    TimerWheel timer_wheel;
+
+    // Emitter each timer was scheduled for.
+    // vector index = entity id
+    struct EmissionTimer
+    {
+        Entity entity = Entity(-1);
+        TimerHandle timer;
+    };
+    std::vector<EmissionTimer> emission_timers;
+
 public:
-    ProjectileEmitSystem() {
+    ProjectileEmitSystem(): timer_wheel(SDL_GetTicks()) {
         RequireComponent<ProjectileEmitterComponent>();
         RequireComponent<TransformComponent>();
         //RequireComponent<SpriteComponent>();
         //RequireComponent<RigidBodyComponent>();
+        WritesComponent<ProjectileEmitterComponent>();
+        ReadsComponent<SpriteComponent>();
+        TrackNewEntities();
+
+        InitProjectilePrefab(friendly_projectile_prefab, GetCollisionLayer("friendly_projectiles"), GetCollisionLayer("enemies"));
+        InitProjectilePrefab(enemy_projectile_prefab, GetCollisionLayer("enemy_projectiles"), GetCollisionLayer("player"));
+    }
+
+    void InitProjectilePrefab(Prefab& prefab, uint32_t layer, uint32_t collision_mask) {
+        prefab.SetRecyclable(true);
+        prefab.Group(projectiles_group);
+        prefab.AddComponent<TransformComponent>();
+        prefab.AddComponent<RigidBodyComponent>();
+        prefab.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
+        prefab.AddComponent<BoxColliderComponent>(4, 4, glm::vec2(0, 0), layer, collision_mask);
+        prefab.AddComponent<ProjectileComponent>();
+    }
+
+    Prefab& GetProjectilePrefab(bool is_friendly) {
+        return is_friendly ? friendly_projectile_prefab : enemy_projectile_prefab;
     }
 
     void SubscribeToEvents(std::unique_ptr<EventBus>& event_bus) {
@@ -33,25 +78,25 @@ public:
         switch (event.sdl_event.key.keysym.sym) {
             case SDLK_SPACE:
                 for (auto entity : GetSystemEntities()) {
-                    if (!entity.HasTag("player")) {
+                    if (!entity.HasTag(player_tag)) {
                         continue;
                     }
                     auto& projectile_emitter = entity.GetComponent<ProjectileEmitterComponent>();
-                    const auto& transform = entity.GetComponent<TransformComponent>();
+                    const auto& transform = entity.ReadComponent<TransformComponent>();
 
                     glm::vec2 projectile_position = transform.position;
                     if (entity.HasComponent<SpriteComponent>()) {
-                        auto sprite = entity.GetComponent<SpriteComponent>();
+                        const auto& sprite = entity.ReadComponent<SpriteComponent>();
                         projectile_position.x += (transform.scale.x * sprite.width / 2);
                         projectile_position.y += (transform.scale.y * sprite.height / 2);
                     }
 
                     // Add a new projectile entity to the registry.
-                    Entity projectile = event.registry->CreateEntity();
-                    projectile.Group("projectiles");
-                    projectile.AddComponent<TransformComponent>(projectile_position, glm::vec2(1.0, 1.0), 0.0);
+                    CommandBuffer& commands = event.registry->GetCommandBuffer();
+                    Entity projectile = commands.Spawn(GetProjectilePrefab(projectile_emitter.is_friendly));
+                    commands.AddComponent<TransformComponent>(projectile, projectile_position, glm::vec2(1.0, 1.0), 0.0);
 
-                    auto& rigid_body = entity.GetComponent<RigidBodyComponent>();
+                    const auto& rigid_body = entity.ReadComponent<RigidBodyComponent>();
                     if (rigid_body.velocity.x == 0 && rigid_body.velocity.y == 0) {
                         projectile_emitter.projectile_velocity.x = 0;
                         projectile_emitter.projectile_velocity.y = -100;
@@ -81,10 +126,8 @@ public:
                             projectile_emitter.projectile_velocity.x = 0;
                         }
                     }
-                    projectile.AddComponent<RigidBodyComponent>(rigid_body.velocity + projectile_emitter.projectile_velocity);
-                    projectile.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
-                    projectile.AddComponent<BoxColliderComponent>(4, 4);
-                    projectile.AddComponent<ProjectileComponent>(projectile_emitter.is_friendly, projectile_emitter.hit_percent_damage, projectile_emitter.projectile_duration);
+                    commands.AddComponent<RigidBodyComponent>(projectile, rigid_body.velocity + projectile_emitter.projectile_velocity);
+                    commands.AddComponent<ProjectileComponent>(projectile, projectile_emitter.is_friendly, projectile_emitter.hit_percent_damage, projectile_emitter.projectile_duration);
 
                     // Update the projectile component last emission to the current milliseconds.
                     projectile_emitter.last_emission_time = SDL_GetTicks();
@@ -93,33 +136,54 @@ public:
         }
     }
 
-    void Update(std::unique_ptr<Registry>& registry) {
-        for (auto &entity : GetSystemEntities()) {
-            if (entity.HasTag("player")) {
-                continue;
+    void Update(std::unique_ptr<Registry>& registry, uint32_t current_time) {
+        // Give every new emitter a repeating timer, the player fires on key presses instead.
+        EachNewEntity([this](Entity entity) {
+            const auto entity_id = entity.GetId();
+            if (static_cast<size_t>(entity_id) >= emission_timers.size()) {
+                emission_timers.resize(entity_id + 1);
+            }
+            EmissionTimer& emission_timer = emission_timers[entity_id];
+            timer_wheel.Cancel(emission_timer.timer);
+            emission_timer.entity = entity;
+            if (entity.HasTag(player_tag)) {
+                return;
+            }
+
+            const auto& projectile_emitter = entity.ReadComponent<ProjectileEmitterComponent>();
+            const int32_t delay = static_cast<int32_t>(projectile_emitter.last_emission_time + projectile_emitter.repeat_frequency - timer_wheel.GetCurrentTime());
+            const uint32_t period = projectile_emitter.repeat_frequency > 0 ? projectile_emitter.repeat_frequency : 1;
+            emission_timer.timer = timer_wheel.Schedule(delay > 0 ? delay : 0, period, static_cast<uint64_t>(entity_id));
+        });
+
+        timer_wheel.Advance(current_time, [this, &registry, current_time](TimerHandle timer, uint64_t entity_id) {
+            Entity entity = emission_timers[entity_id].entity;
+            // The emitter died or left the system (e.g. lost its emitter component).
+            if (!entity.IsAlive() || !HasEntity(entity)) {
+                timer_wheel.Cancel(timer);
+                return;
             }
             auto& projectile_emitter = entity.GetComponent<ProjectileEmitterComponent>();
-            const auto &transform = entity.GetComponent<TransformComponent>();
-            // Check if its time to re-emit a new projectile.
-            if (SDL_GetTicks() - projectile_emitter.last_emission_time > projectile_emitter.repeat_frequency) {
-                glm::vec2 projectile_position = transform.position;
-                if (entity.HasComponent<SpriteComponent>()) {
-                    auto &sprite = entity.GetComponent<SpriteComponent>();
-                    projectile_position.x += (transform.scale.x * sprite.width / 2);
-                    projectile_position.y += (transform.scale.y * sprite.height / 2);
-                }
-                // Add a new projectile entity to the registry.
-                Entity projectile = registry->CreateEntity();
-                projectile.Group("projectiles");
-                projectile.AddComponent<TransformComponent>(projectile_position, glm::vec2(1.0, 1.0), 0.0);
-                projectile.AddComponent<RigidBodyComponent>(projectile_emitter.projectile_velocity);
-                projectile.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
-                projectile.AddComponent<BoxColliderComponent>(4, 4);
-                projectile.AddComponent<ProjectileComponent>(projectile_emitter.is_friendly, projectile_emitter.hit_percent_damage, projectile_emitter.projectile_duration);
-
-                // Update the projectile component last emission to the current milliseconds.
-                projectile_emitter.last_emission_time = SDL_GetTicks();
+            // A short repeat frequency may fire several times in one frame, emit at most once per frame.
+            if (projectile_emitter.last_emission_time == static_cast<int>(current_time)) {
+                return;
             }
-        }
+            const auto &transform = entity.ReadComponent<TransformComponent>();
+            glm::vec2 projectile_position = transform.position;
+            if (entity.HasComponent<SpriteComponent>()) {
+                const auto &sprite = entity.ReadComponent<SpriteComponent>();
+                projectile_position.x += (transform.scale.x * sprite.width / 2);
+                projectile_position.y += (transform.scale.y * sprite.height / 2);
+            }
+            // Add a new projectile entity to the registry (created in the next registry update).
+            CommandBuffer& commands = registry->GetCommandBuffer();
+            Entity projectile = commands.Spawn(GetProjectilePrefab(projectile_emitter.is_friendly));
+            commands.AddComponent<TransformComponent>(projectile, projectile_position, glm::vec2(1.0, 1.0), 0.0);
+            commands.AddComponent<RigidBodyComponent>(projectile, projectile_emitter.projectile_velocity);
+            commands.AddComponent<ProjectileComponent>(projectile, projectile_emitter.is_friendly, projectile_emitter.hit_percent_damage, projectile_emitter.projectile_duration);
+
+            // Update the projectile component last emission to the current milliseconds.
+            projectile_emitter.last_emission_time = current_time;
+        });
     }
 };
\ No newline at end of file
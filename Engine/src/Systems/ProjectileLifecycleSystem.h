@@ -1,25 +1,57 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <vector>
 
 #include "../ECS/ECS.h"
+#include "../Timer/TimerWheel.h"
 #include "../Components/ProjectileComponent.h"
 
 class ProjectileLifecycleSystem : public System
 {
+private:
+    // Expiry timer of every projectile, scheduled when the projectile appears,
+    // so each frame only visits the projectiles that reach their duration limit.
+    TimerWheel timer_wheel;
+
+    // Projectile each timer was scheduled for.
+    // vector index = entity id
+    struct ExpiryTimer
+    {
+        Entity entity = Entity(-1);
+        TimerHandle timer;
+    };
+    std::vector<ExpiryTimer> expiry_timers;
+
 public:
-    ProjectileLifecycleSystem() {
+    ProjectileLifecycleSystem(): timer_wheel(SDL_GetTicks()) {
         RequireComponent<ProjectileComponent>();
+        TrackNewEntities();
     }
 
-    void Update() {
-        for (auto entity : GetSystemEntities()) {
-            const auto projectile = entity.GetComponent<ProjectileComponent>();
+    void Update(uint32_t current_time) {
+        // New and recycled projectiles replace the timer of the previous user of their id.
+        EachNewEntity([this](Entity entity) {
+            const auto entity_id = entity.GetId();
+            if (static_cast<size_t>(entity_id) >= expiry_timers.size()) {
+                expiry_timers.resize(entity_id + 1);
+            }
+            ExpiryTimer& expiry_timer = expiry_timers[entity_id];
+            timer_wheel.Cancel(expiry_timer.timer);
+
+            const auto& projectile = entity.ReadComponent<ProjectileComponent>();
+            const int32_t delay = static_cast<int32_t>(projectile.start_time + projectile.duration - timer_wheel.GetCurrentTime());
+            expiry_timer.entity = entity;
+            expiry_timer.timer = timer_wheel.Schedule(delay > 0 ? delay : 0, 0, static_cast<uint64_t>(entity_id));
+        });
 
-            // Kill projectiles after they reach their duration limit.
-            if (SDL_GetTicks() - projectile.start_time > projectile.duration) {
+        // Kill projectiles after they reach their duration limit.
+        timer_wheel.Advance(current_time, [this](TimerHandle, uint64_t entity_id) {
+            Entity entity = expiry_timers[entity_id].entity;
+            // The projectile may already be dead (hit something or left the map).
+            if (entity.IsAlive()) {
                 entity.Kill();
             }
-        }
+        });
     }
-};
\ No newline at end of file
+};
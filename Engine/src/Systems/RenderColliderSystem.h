@@ -14,7 +14,7 @@ public:
         RequireComponent<BoxColliderComponent>();
     }
 
-    static bool intersect(TransformComponent& a_tc, BoxColliderComponent& a_bc, TransformComponent& b_tc, BoxColliderComponent& b_bc) {
+    static bool intersect(const TransformComponent& a_tc, const BoxColliderComponent& a_bc, const TransformComponent& b_tc, const BoxColliderComponent& b_bc) {
         return (
             a_tc.position.x + a_bc.offset.x <= b_tc.position.x + b_bc.offset.x + b_bc.width &&
             a_tc.position.x + a_bc.offset.x + a_bc.width >= b_tc.position.x + b_bc.offset.x &&
@@ -23,7 +23,7 @@ public:
             );
     }
 
-    static void draw_collision_box(SDL_Renderer* renderer, SDL_Rect& camera, TransformComponent& x_tc, BoxColliderComponent& x_bc, int r = 255, int g = 255, int b = 255, int a = 255) {
+    static void draw_collision_box(SDL_Renderer* renderer, SDL_Rect& camera, const TransformComponent& x_tc, const BoxColliderComponent& x_bc, int r = 255, int g = 255, int b = 255, int a = 255) {
         SDL_Rect obj_rect = {
             static_cast<int>(x_tc.position.x + x_bc.offset.x - camera.x),
             static_cast<int>(x_tc.position.y + x_bc.offset.y - camera.y),
@@ -35,21 +35,21 @@ public:
     }
 
     void Update(SDL_Renderer* renderer, SDL_Rect& camera) {
-        auto entities = GetSystemEntities();
+        const auto entities = GetSystemEntities();
         for (auto i = entities.begin(); i != entities.end(); i++) {
             Entity a = *i;
-            auto& a_tc = a.GetComponent<TransformComponent>();
-            auto& a_bc = a.GetComponent<BoxColliderComponent>();
+            const auto& a_tc = a.ReadComponent<TransformComponent>();
+            const auto& a_bc = a.ReadComponent<BoxColliderComponent>();
             for (auto j = i; j != entities.end(); j++) {
                 Entity b = *j;
                 if (a == b) {
                     continue;
                 }
-                auto& b_tc = b.GetComponent<TransformComponent>();
-                auto& b_bc = b.GetComponent<BoxColliderComponent>();
+                const auto& b_tc = b.ReadComponent<TransformComponent>();
+                const auto& b_bc = b.ReadComponent<BoxColliderComponent>();
                 draw_collision_box(renderer, camera, a_tc, a_bc, 255, 165, 0, 255);
                 draw_collision_box(renderer, camera, b_tc, b_bc, 255, 165, 0, 255);
-                bool is_collision = intersect(a_tc, a_bc, b_tc, b_bc);
+                bool is_collision = CanCollide(a_bc.layer, a_bc.collision_mask, b_bc.layer, b_bc.collision_mask) && intersect(a_tc, a_bc, b_tc, b_bc);
                 if (is_collision) {
                     draw_collision_box(renderer, camera, a_tc, a_bc, 255, 0, 0, 255);
                     draw_collision_box(renderer, camera, b_tc, b_bc, 255, 0, 0, 255);
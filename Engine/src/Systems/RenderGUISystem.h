@@ -15,8 +15,24 @@
 
 class RenderGUISystem : public System
 {
+private:
+    // Components shared by the enemies created from the window, the other values come from the inputs.
+    // Killed enemies are recycled by the next spawns.
+    Prefab enemy_prefab;
+
 public:
-    RenderGUISystem() = default;
+    RenderGUISystem() {
+        SDL_Color green = {0, 255, 0};
+        enemy_prefab.SetRecyclable(true);
+        enemy_prefab.Group("enemies");
+        enemy_prefab.AddComponent<TransformComponent>();
+        enemy_prefab.AddComponent<RigidBodyComponent>();
+        enemy_prefab.AddComponent<SpriteComponent>();
+        enemy_prefab.AddComponent<BoxColliderComponent>(32, 32, glm::vec2(0, 0), GetCollisionLayer("enemies"), GetCollisionLayer("friendly_projectiles") | GetCollisionLayer("obstacles"));
+        enemy_prefab.AddComponent<ProjectileEmitterComponent>();
+        enemy_prefab.AddComponent<HealthComponent>();
+        enemy_prefab.AddComponent<HealthLabelComponent>("charriot-font", green);
+    }
 
     void Update(const std::unique_ptr<Registry>& registry, std::unique_ptr<AssetStore>& asset_store) {
         ImGui::NewFrame();
@@ -72,16 +88,13 @@ public:
             ImGui::InputInt("hit-percent", &hitp);
 
             if (ImGui::Button("create")) {
-                Entity enemy = registry->CreateEntity();
-                enemy.Group("enemies");
-                enemy.AddComponent<TransformComponent>(glm::vec2(x_pos, y_pos), glm::vec2(x_scale, y_scale), rotation * (M_PI / 180));
-                enemy.AddComponent<RigidBodyComponent>(glm::vec2(x_vel, y_vel));
-                enemy.AddComponent<SpriteComponent>(sprite_image, 32, 32, 1);
-                enemy.AddComponent<BoxColliderComponent>(32, 32);
-                enemy.AddComponent<ProjectileEmitterComponent>(glm::vec2(px_vel, py_vel), freq * 1000, dur * 1000, 10, false);
-                enemy.AddComponent<HealthComponent>(hitp);
-                SDL_Color green = {0, 255, 0};
-                enemy.AddComponent<HealthLabelComponent>("charriot-font", green);
+                registry->Spawn(enemy_prefab, 1, [&](Entity enemy, int) {
+                    enemy.GetComponent<TransformComponent>() = TransformComponent(glm::vec2(x_pos, y_pos), glm::vec2(x_scale, y_scale), rotation * (M_PI / 180));
+                    enemy.GetComponent<RigidBodyComponent>() = RigidBodyComponent(glm::vec2(x_vel, y_vel));
+                    enemy.GetComponent<SpriteComponent>() = SpriteComponent(sprite_image, 32, 32, 1);
+                    enemy.GetComponent<ProjectileEmitterComponent>() = ProjectileEmitterComponent(glm::vec2(px_vel, py_vel), freq * 1000, dur * 1000, 10, false);
+                    enemy.ReplaceComponent<HealthComponent>(hitp);
+                });
             }
         }
         ImGui::End();
@@ -13,6 +13,10 @@
 
 class RenderHealthBarSystem : public System
 {
+private:
+    const TagId player_tag = Registry::GetTagId("player");
+    const GroupId enemies_group = Registry::GetGroupId("enemies");
+
 public:
     RenderHealthBarSystem() {
         RequireComponent<HealthLabelComponent>();
@@ -22,9 +26,9 @@ public:
 
     void Update(SDL_Renderer* renderer, const SDL_Rect& camera) {
         for (auto& entity : GetSystemEntities()) {
-            if (entity.HasTag("player") || entity.BelongsToGroup("enemies")) {
-                auto& health = entity.GetComponent<HealthComponent>();
-                auto& transform = entity.GetComponent<TransformComponent>();
+            if (entity.HasTag(player_tag) || entity.BelongsToGroup(enemies_group)) {
+                const auto& health = entity.ReadComponent<HealthComponent>();
+                const auto& transform = entity.ReadComponent<TransformComponent>();
 
                 auto& health_label = entity.GetComponent<HealthLabelComponent>();
 
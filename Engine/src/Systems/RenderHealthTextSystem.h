@@ -2,6 +2,7 @@
 
 #include <SDL2/SDL.h>
 #include <string>
+#include <vector>
 
 #include "../ECS/ECS.h"
 
@@ -13,6 +14,68 @@
 
 class RenderHealthTextSystem : public System
 {
+private:
+    const TagId player_tag = Registry::GetTagId("player");
+    const GroupId enemies_group = Registry::GetGroupId("enemies");
+
+    // Rendered text of every health label, rebuilt only when the health of its entity changes.
+    // vector index = entity id
+    // The textures belong to the renderer, which frees the remaining ones when it is destroyed.
+    struct HealthText
+    {
+        Entity entity = Entity(-1);
+        SDL_Texture* texture = nullptr;
+        int width = 0;
+        int height = 0;
+        // Whether the entity id is in textured_entity_ids.
+        bool is_listed = false;
+    };
+    std::vector<HealthText> health_texts;
+
+    // Ids of the entities that may have a texture, so the textures of the entities that died
+    // or left the system are freed without scanning every health text.
+    std::vector<int> textured_entity_ids;
+
+    // Registry tick before the one of the previous Update(), the health changes since are not rendered yet.
+    uint32_t last_tick = 0;
+
+    HealthText& GetHealthText(Entity entity) {
+        const auto entity_id = entity.GetId();
+        if (static_cast<size_t>(entity_id) >= health_texts.size()) {
+            health_texts.resize(entity_id + 1);
+        }
+        HealthText& health_text = health_texts[entity_id];
+        // The entity id was reused: the text belongs to a destroyed entity.
+        if (health_text.entity != entity) {
+            InvalidateHealthText(health_text);
+            health_text.entity = entity;
+        }
+        return health_text;
+    }
+
+    static void InvalidateHealthText(HealthText& health_text) {
+        if (health_text.texture) {
+            SDL_DestroyTexture(health_text.texture);
+            health_text.texture = nullptr;
+        }
+    }
+
+    void FreeStaleHealthTexts() {
+        size_t num_textured_entities = 0;
+        for (int entity_id : textured_entity_ids) {
+            HealthText& health_text = health_texts[entity_id];
+            if (health_text.texture && (!health_text.entity.IsAlive() || !HasEntity(health_text.entity))) {
+                InvalidateHealthText(health_text);
+            }
+            if (!health_text.texture) {
+                health_text.is_listed = false;
+                continue;
+            }
+            textured_entity_ids[num_textured_entities++] = entity_id;
+        }
+        textured_entity_ids.resize(num_textured_entities);
+    }
+
 public:
     RenderHealthTextSystem() {
         RequireComponent<HealthLabelComponent>();
@@ -20,53 +83,67 @@ public:
         RequireComponent<TransformComponent>();
     }
 
-    void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& asset_store, const SDL_Rect& camera) {
-        for (auto& entity : GetSystemEntities()) {
-            if (entity.HasTag("player") || entity.BelongsToGroup("enemies")) {
-                auto& health = entity.GetComponent<HealthComponent>();
-                auto& transform = entity.GetComponent<TransformComponent>();
+    void Update(std::unique_ptr<Registry>& registry, SDL_Renderer* renderer, std::unique_ptr<AssetStore>& asset_store, const SDL_Rect& camera) {
+        // Only the entities whose health changed since the last frame need a new text,
+        // and the texts of the entities that are gone are freed.
+        registry->EachChangedEntity<HealthComponent>(last_tick, [this](Entity entity) {
+            if (static_cast<size_t>(entity.GetId()) < health_texts.size()) {
+                InvalidateHealthText(health_texts[entity.GetId()]);
+            }
+        });
+        last_tick = registry->GetTick() - 1;
+        FreeStaleHealthTexts();
 
+        for (auto& entity : GetSystemEntities()) {
+            if (entity.HasTag(player_tag) || entity.BelongsToGroup(enemies_group)) {
+                const auto& transform = entity.ReadComponent<TransformComponent>();
                 auto& health_label = entity.GetComponent<HealthLabelComponent>();
-                health_label.text = std::to_string(health.health_percentage) + "%";
+                HealthText& health_text = GetHealthText(entity);
+
+                if (!health_text.texture) {
+                    const auto& health = entity.ReadComponent<HealthComponent>();
+                    health_label.text = std::to_string(health.health_percentage) + "%";
+
+                    if (health.health_percentage >= 71) {
+                        health_label.color = {0, 255, 0};
+                    }
+
+                    if (health.health_percentage >= 1 && health.health_percentage <= 70) {
+                        health_label.color = {255, 165, 0};
+                    }
+
+                    if (health.health_percentage >= 0 && health.health_percentage <= 20) {
+                        health_label.color = {255, 0, 0};
+                    }
+
+                    SDL_Surface* surface = TTF_RenderText_Blended(
+                        asset_store->GetFont(health_label.asset_id),
+                        health_label.text.c_str(),
+                        health_label.color
+                    );
+
+                    health_text.texture = SDL_CreateTextureFromSurface(renderer, surface);
+                    SDL_FreeSurface(surface);
+
+                    SDL_QueryTexture(health_text.texture, NULL, NULL, &health_text.width, &health_text.height);
+                    if (!health_text.is_listed) {
+                        health_text.is_listed = true;
+                        textured_entity_ids.push_back(entity.GetId());
+                    }
+                }
 
                 health_label.position.x = transform.position.x + 20;
                 health_label.position.y = transform.position.y - 25;
 
-                if (health.health_percentage >= 71) {
-                    health_label.color = {0, 255, 0};
-                }
-
-                if (health.health_percentage >= 1 && health.health_percentage <= 70) {
-                    health_label.color = {255, 165, 0};
-                }
-
-                if (health.health_percentage >= 0 && health.health_percentage <= 20) {
-                    health_label.color = {255, 0, 0};
-                }
-
-                SDL_Surface* surface = TTF_RenderText_Blended(
-                    asset_store->GetFont(health_label.asset_id),
-                    health_label.text.c_str(),
-                    health_label.color
-                );
-
-                SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-                SDL_FreeSurface(surface);
-
-                int label_width = 0;
-                int label_height = 0;
-
-                SDL_QueryTexture(texture, NULL, NULL, &label_width, &label_height);
-
                 SDL_Rect dest_rect = {
                     static_cast<int>(health_label.position.x - camera.x),
                     static_cast<int>(health_label.position.y - camera.y),
-                    label_width,
-                    label_height
+                    health_text.width,
+                    health_text.height
                 };
 
-                SDL_RenderCopy(renderer, texture, NULL, &dest_rect);
+                SDL_RenderCopy(renderer, health_text.texture, NULL, &dest_rect);
             }
         }
     }
-};
\ No newline at end of file
+};
@@ -11,30 +11,38 @@
 
 class RenderSystem : public System
 {
+private:
+    struct Renderable
+    {
+        const TransformComponent* transform;
+        const SpriteComponent* sprite;
+    };
+
+    // Scratch list sorted by z-index every frame. It keeps its capacity between frames.
+    std::vector<Renderable> sorted_renderables;
+
 public:
     RenderSystem() {
         RequireComponent<TransformComponent>();
         RequireComponent<SpriteComponent>();
     }
 
-    static bool compare_by_zindex(const Entity& a, const Entity& b) {
-        int a_zindex = a.GetComponent<SpriteComponent>().zindex;
-        int b_zindex = b.GetComponent<SpriteComponent>().zindex;
-        //Logger::Log("a_zindex = " + std::to_string(a_zindex));
-        //Logger::Log("b_zindex = " + std::to_string(b_zindex));
-        return a_zindex < b_zindex;
+    static bool compare_by_zindex(const Renderable& a, const Renderable& b) {
+        return a.sprite->zindex < b.sprite->zindex;
     }
 
-    void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& asset_store, SDL_Rect& camera) {
+    void Update(std::unique_ptr<Registry>& registry, SDL_Renderer* renderer, std::unique_ptr<AssetStore>& asset_store, SDL_Rect& camera) {
 
-        auto entities = GetSystemEntities();
-        std::sort(entities.begin(), entities.end(), compare_by_zindex);
+        sorted_renderables.clear();
+        registry->View<TransformComponent, SpriteComponent>().Each([this](const TransformComponent& transform, const SpriteComponent& sprite) {
+            sorted_renderables.push_back({&transform, &sprite});
+        });
+        std::sort(sorted_renderables.begin(), sorted_renderables.end(), compare_by_zindex);
 
         // Loop all entities that the system is interested in...
-        for (auto entity : entities) {
-            // Update entity position based on its velocity.
-            const auto& transform = entity.GetComponent<TransformComponent>();
-            const auto sprite = entity.GetComponent<SpriteComponent>();
+        for (const auto& renderable : sorted_renderables) {
+            const auto& transform = *renderable.transform;
+            const auto& sprite = *renderable.sprite;
 
             bool is_entity_outside_camera_view = (
                 transform.position.x + (transform.scale.x * sprite.width)  < camera.x ||
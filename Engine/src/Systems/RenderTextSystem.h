@@ -15,7 +15,7 @@ public:
 
     void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& asset_store, const SDL_Rect& camera) {
         for (auto& entity : GetSystemEntities()) {
-            const auto& text_label = entity.GetComponent<TextLabelComponent>();
+            const auto& text_label = entity.ReadComponent<TextLabelComponent>();
             SDL_Surface* surface = TTF_RenderText_Blended(
                 asset_store->GetFont(text_label.asset_id),
                 text_label.text.c_str(),
@@ -76,6 +76,9 @@ class ScriptSystem : public System
 public:
     ScriptSystem() {
         RequireComponent<ScriptComponent>();
+
+        // Lua scripts may touch any component and the Lua state is not thread-safe.
+        RequireExclusiveAccess();
     }
 
     void CreateLuaBindings(sol::state& lua) {
@@ -84,8 +87,9 @@ public:
             "entity",
             "get_id", &Entity::GetId,
             "destroy", &Entity::Kill,
-            "has_tag", &Entity::HasTag,
-            "belongs_to_group", &Entity::BelongsToGroup
+            "is_alive", &Entity::IsAlive,
+            "has_tag", sol::resolve<bool(const std::string&) const>(&Entity::HasTag),
+            "belongs_to_group", sol::resolve<bool(const std::string&) const>(&Entity::BelongsToGroup)
             );
 
         // Create all bindings between C++ and Lua.
@@ -0,0 +1,182 @@
+#include "TimerWheel.h"
+
+// Range covered by each level, the top level also holds the timers that are further away.
+static const uint32_t LEVEL_RANGES[TIMER_WHEEL_LEVELS] = {
+    1u << (TIMER_WHEEL_SLOT_BITS * 1),
+    1u << (TIMER_WHEEL_SLOT_BITS * 2),
+    1u << (TIMER_WHEEL_SLOT_BITS * 3),
+    1u << (TIMER_WHEEL_SLOT_BITS * 4)
+};
+
+// Time comparison that survives the wrap around of the millisecond counter.
+static bool IsBeforeOrAt(uint32_t time, uint32_t other_time) {
+    return static_cast<int32_t>(time - other_time) <= 0;
+}
+
+TimerWheel::TimerWheel(uint32_t current_time): current_time(current_time) {
+    slot_heads.resize(TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS, -1);
+}
+
+void TimerWheel::Insert(int timer_index) {
+    Timer& timer = timers[timer_index];
+    const uint32_t remaining_time = timer.expiry_time - current_time;
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && remaining_time >= LEVEL_RANGES[level]) {
+        level++;
+    }
+    // Timers beyond the range of the wheel wait in the last slot the top level can reach,
+    // and are placed again when that slot is cascaded.
+    uint32_t slot_time = timer.expiry_time;
+    if (remaining_time >= LEVEL_RANGES[TIMER_WHEEL_LEVELS - 1]) {
+        slot_time = current_time + LEVEL_RANGES[TIMER_WHEEL_LEVELS - 1] - 1;
+    }
+    const int slot = level * TIMER_WHEEL_SLOTS + ((slot_time >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+
+    timer.slot = slot;
+    timer.previous = -1;
+    timer.next = slot_heads[slot];
+    if (timer.next != -1) {
+        timers[timer.next].previous = timer_index;
+    }
+    slot_heads[slot] = timer_index;
+}
+
+void TimerWheel::Unlink(int timer_index) {
+    Timer& timer = timers[timer_index];
+    if (timer.previous != -1) {
+        timers[timer.previous].next = timer.next;
+    } else {
+        slot_heads[timer.slot] = timer.next;
+    }
+    if (timer.next != -1) {
+        timers[timer.next].previous = timer.previous;
+    }
+    timer.slot = FREE_SLOT;
+}
+
+void TimerWheel::FreeTimer(int timer_index) {
+    Timer& timer = timers[timer_index];
+    // Bumping the generation makes all the handles of the timer stale.
+    timer.generation++;
+    timer.slot = FREE_SLOT;
+    timer.next = first_free_timer;
+    first_free_timer = timer_index;
+}
+
+bool TimerWheel::BeginCallback(TimerHandle handle) {
+    if (!IsScheduled(handle)) {
+        return false;
+    }
+    // A single shot timer is released before its callback, which may reuse it.
+    if (timers[handle.index].slot == DUE_SLOT) {
+        FreeTimer(handle.index);
+    }
+    return true;
+}
+
+void TimerWheel::Cascade(int level, int slot) {
+    const int slot_index = level * TIMER_WHEEL_SLOTS + slot;
+    int timer_index = slot_heads[slot_index];
+    slot_heads[slot_index] = -1;
+    while (timer_index != -1) {
+        const int next = timers[timer_index].next;
+        Insert(timer_index);
+        timer_index = next;
+    }
+}
+
+TimerHandle TimerWheel::Schedule(uint32_t delay, uint32_t period, uint64_t user_data) {
+    int timer_index;
+    if (first_free_timer != -1) {
+        timer_index = first_free_timer;
+        first_free_timer = timers[timer_index].next;
+    } else {
+        timer_index = static_cast<int>(timers.size());
+        timers.emplace_back();
+    }
+    num_scheduled_timers++;
+
+    Timer& timer = timers[timer_index];
+    // The slot of the current time was already processed, so a timer fires at the earliest 1 ms from now.
+    timer.expiry_time = current_time + (delay > 0 ? delay : 1);
+    timer.period = period;
+    timer.user_data = user_data;
+    Insert(timer_index);
+
+    TimerHandle handle;
+    handle.index = timer_index;
+    handle.generation = timer.generation;
+    return handle;
+}
+
+bool TimerWheel::Cancel(TimerHandle handle) {
+    if (!IsScheduled(handle)) {
+        return false;
+    }
+    if (timers[handle.index].slot != DUE_SLOT) {
+        Unlink(handle.index);
+        num_scheduled_timers--;
+    }
+    FreeTimer(handle.index);
+    return true;
+}
+
+bool TimerWheel::IsScheduled(TimerHandle handle) const {
+    return handle.index >= 0 && handle.index < static_cast<int>(timers.size()) &&
+        timers[handle.index].generation == handle.generation && timers[handle.index].slot != FREE_SLOT;
+}
+
+void TimerWheel::CollectDueTimers(uint32_t time) {
+    due_timers.clear();
+
+    // Nothing can fire, skip the ticks in between.
+    if (num_scheduled_timers == 0) {
+        current_time = time;
+        return;
+    }
+
+    while (static_cast<int32_t>(time - current_time) > 0) {
+        current_time++;
+
+        // Every time a level wraps around, the next slot of the level above is spread over the levels below.
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if (((current_time >> ((level - 1) * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1)) != 0) {
+                break;
+            }
+            Cascade(level, (current_time >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+        }
+
+        const int slot_index = current_time & (TIMER_WHEEL_SLOTS - 1);
+        int timer_index = slot_heads[slot_index];
+        slot_heads[slot_index] = -1;
+        while (timer_index != -1) {
+            Timer& timer = timers[timer_index];
+            const int next = timer.next;
+
+            if (!IsBeforeOrAt(timer.expiry_time, current_time)) {
+                // Not due yet, can only happen to a timer that was beyond the range of the wheel.
+                Insert(timer_index);
+            } else {
+                DueTimer due_timer;
+                due_timer.handle.index = timer_index;
+                due_timer.handle.generation = timer.generation;
+                due_timer.user_data = timer.user_data;
+                due_timers.push_back(due_timer);
+
+                if (timer.period > 0) {
+                    timer.expiry_time += timer.period;
+                    Insert(timer_index);
+                } else {
+                    timer.slot = DUE_SLOT;
+                    num_scheduled_timers--;
+                }
+            }
+            timer_index = next;
+        }
+
+        if (num_scheduled_timers == 0) {
+            current_time = time;
+        }
+    }
+}
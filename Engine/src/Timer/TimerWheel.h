@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Number of levels of the timer wheel, and number of slots per level (must be a power of two).
+// Level 0 has a slot per millisecond, every level above covers TIMER_WHEEL_SLOTS times the range of the one below,
+// so timers up to 2^24 ms (about 4.6 hours) ahead are placed directly. Later timers wait in the top level.
+const int TIMER_WHEEL_LEVELS = 4;
+const int TIMER_WHEEL_SLOT_BITS = 6;
+const int TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS;
+
+// Identifies a scheduled timer. The handle of a timer that fired (once) or was cancelled becomes stale.
+struct TimerHandle
+{
+    int index = -1;
+    int generation = 0;
+};
+
+// Hierarchical timer wheel: scheduling and cancelling a timer is O(1), and advancing the time
+// only visits the timers that are due (plus the occasional move of a timer to a lower level).
+// Time is in milliseconds, as given by SDL_GetTicks(), and may wrap around.
+// Each timer carries 64 bits of user data that are passed back when it fires.
+// Timer nodes are recycled, so the wheel does not allocate once it has grown to its working size.
+class TimerWheel
+{
+private:
+    static const int FREE_SLOT = -1;
+    static const int DUE_SLOT = -2;
+
+    struct Timer
+    {
+        uint32_t expiry_time;
+        uint32_t period;
+        uint64_t user_data;
+        int generation = 0;
+        // Doubly linked list of the slot the timer is in (-1 terminated), or of the free timers.
+        int next = -1;
+        int previous = -1;
+        // Slot index, FREE_SLOT or DUE_SLOT for a single shot timer waiting for its callback.
+        int slot = FREE_SLOT;
+    };
+
+    struct DueTimer
+    {
+        TimerHandle handle;
+        uint64_t user_data;
+    };
+
+    uint32_t current_time;
+    std::vector<Timer> timers;
+    int first_free_timer = -1;
+    int num_scheduled_timers = 0;
+
+    // First timer of every slot, index = level * TIMER_WHEEL_SLOTS + slot.
+    std::vector<int> slot_heads;
+
+    // Timers that fired during the current Advance().
+    std::vector<DueTimer> due_timers;
+
+    void Insert(int timer_index);
+    void Unlink(int timer_index);
+    void FreeTimer(int timer_index);
+    // Returns false if the timer was cancelled since it was collected.
+    bool BeginCallback(TimerHandle handle);
+    // Moves the timers of a slot down to the levels matching their remaining time.
+    void Cascade(int level, int slot);
+    // Advances to current_time and fills due_timers.
+    void CollectDueTimers(uint32_t time);
+
+public:
+    explicit TimerWheel(uint32_t current_time = 0);
+
+    uint32_t GetCurrentTime() const { return current_time; }
+    int GetNumScheduledTimers() const { return num_scheduled_timers; }
+
+    // Schedule a timer that fires delay milliseconds from the current time of the wheel,
+    // then every period milliseconds until it is cancelled (period 0 fires only once).
+    TimerHandle Schedule(uint32_t delay, uint32_t period, uint64_t user_data);
+    // Returns false if the timer already fired or was cancelled.
+    bool Cancel(TimerHandle handle);
+    bool IsScheduled(TimerHandle handle) const;
+
+    // Move the wheel to time and call func(TimerHandle, uint64_t user_data) for every timer that fires,
+    // in the order they expired. A repeating timer fires as many times as its period elapsed.
+    // func may schedule new timers and cancel any timer, including the ones that are still to be called back,
+    // but must not call Advance().
+    template <typename TFunc>
+    void Advance(uint32_t time, TFunc&& func) {
+        CollectDueTimers(time);
+        for (const auto& due_timer : due_timers) {
+            if (BeginCallback(due_timer.handle)) {
+                func(due_timer.handle, due_timer.user_data);
+            }
+        }
+    }
+};
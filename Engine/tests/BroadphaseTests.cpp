@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../src/Physics/AabbKernel.h"
+#include "../src/Physics/Broadphase.h"
+#include "../src/Physics/BroadphaseBenchmark.h"
+#include "Test.h"
+
+// Moving boxes of a few sizes, some of them replaced every frame so the broadphases also see ids come and go.
+class MovingBoxes
+{
+private:
+    struct Box
+    {
+        int id;
+        float x, y, velocity_x, velocity_y, width, height;
+        CollisionFilter filter;
+    };
+
+    std::mt19937 random;
+    std::vector<Box> boxes;
+    int next_id = 0;
+    bool has_layers;
+
+public:
+    const float world_width = 3200.0f;
+    const float world_height = 1920.0f;
+
+    MovingBoxes(int count, unsigned int seed, bool has_layers) : random(seed), has_layers(has_layers) {
+        for (int i = 0; i < count; i++) {
+            AddBox();
+        }
+    }
+
+    void AddBox() {
+        std::uniform_real_distribution<float> x(0.0f, world_width), y(0.0f, world_height), velocity(-3.0f, 3.0f);
+        Box box;
+        box.id = next_id++;
+        box.x = x(random);
+        box.y = y(random);
+        box.velocity_x = velocity(random);
+        box.velocity_y = velocity(random);
+        // Mostly small boxes, with the odd large one that spans many grid cells.
+        const unsigned int size = random() % 100;
+        box.width = box.height = size == 0 ? 300.0f : size < 25 ? 32.0f : 4.0f;
+        box.filter = has_layers ? CollisionFilter{1u << (random() % 4), static_cast<uint32_t>(random() % 16)} : CollisionFilter{DEFAULT_COLLISION_LAYER, ALL_COLLISION_LAYERS};
+        boxes.push_back(box);
+    }
+
+    void Step() {
+        for (auto& box : boxes) {
+            box.x += box.velocity_x;
+            box.y += box.velocity_y;
+        }
+        for (size_t i = 0; i < boxes.size() / 50; i++) {
+            boxes[random() % boxes.size()] = boxes.back();
+            boxes.pop_back();
+            AddBox();
+        }
+        std::shuffle(boxes.begin(), boxes.end(), random);
+    }
+
+    void GetFrame(std::vector<Aabb>& frame_boxes, std::vector<CollisionFilter>& frame_filters, std::vector<int>& frame_ids) const {
+        frame_boxes.clear();
+        frame_filters.clear();
+        frame_ids.clear();
+        for (const auto& box : boxes) {
+            frame_boxes.push_back({box.x, box.y, box.x + box.width, box.y + box.height});
+            frame_filters.push_back(box.filter);
+            frame_ids.push_back(box.id);
+        }
+    }
+};
+
+static std::vector<std::pair<int, int>> FindBruteForcePairs(const std::vector<Aabb>& boxes, const std::vector<CollisionFilter>& filters) {
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < static_cast<int>(boxes.size()); i++) {
+        for (int j = i + 1; j < static_cast<int>(boxes.size()); j++) {
+            if (CanCollide(filters[i], filters[j]) && Overlaps(boxes[i], boxes[j])) {
+                pairs.emplace_back(i, j);
+            }
+        }
+    }
+    return pairs;
+}
+
+// Every broadphase finds exactly the overlapping pairs that brute force finds, each once, and only pairs that can collide.
+static void TestBroadphasesMatchBruteForce() {
+    for (bool has_layers : {false, true}) {
+        for (const char* name : BROADPHASE_NAMES) {
+            std::unique_ptr<IBroadphase> broadphase = CreateBroadphase(name);
+            CHECK(broadphase != nullptr);
+            MovingBoxes moving_boxes(800, 7, has_layers);
+            std::vector<Aabb> boxes;
+            std::vector<CollisionFilter> filters;
+            std::vector<int> ids;
+            std::vector<std::pair<int, int>> pairs;
+            for (int frame = 0; frame < 30; frame++) {
+                moving_boxes.Step();
+                moving_boxes.GetFrame(boxes, filters, ids);
+                broadphase->Update(boxes.data(), filters.data(), ids.data(), static_cast<int>(boxes.size()), moving_boxes.world_width, moving_boxes.world_height);
+                pairs.clear();
+                broadphase->FindCandidatePairs(pairs);
+
+                std::vector<std::pair<int, int>> overlapping_pairs;
+                for (const auto& pair : pairs) {
+                    CHECK(pair.first < pair.second);
+                    CHECK(CanCollide(filters[pair.first], filters[pair.second]));
+                    if (Overlaps(boxes[pair.first], boxes[pair.second])) {
+                        overlapping_pairs.push_back(pair);
+                    }
+                }
+                std::sort(pairs.begin(), pairs.end());
+                CHECK(std::adjacent_find(pairs.begin(), pairs.end()) == pairs.end());
+                std::sort(overlapping_pairs.begin(), overlapping_pairs.end());
+                CHECK(overlapping_pairs == FindBruteForcePairs(boxes, filters));
+            }
+        }
+    }
+}
+
+// Boxes outside of the world are still found.
+static void TestBroadphasesFindBoxesOutsideTheWorld() {
+    const std::vector<Aabb> boxes = {
+        {-100.0f, -100.0f, -90.0f, -90.0f}, {-95.0f, -95.0f, -80.0f, -80.0f},
+        {5000.0f, 500.0f, 5010.0f, 510.0f}, {5005.0f, 505.0f, 5020.0f, 520.0f},
+        {100.0f, 100.0f, 110.0f, 110.0f}
+    };
+    const std::vector<CollisionFilter> filters(boxes.size(), CollisionFilter{DEFAULT_COLLISION_LAYER, ALL_COLLISION_LAYERS});
+    const std::vector<int> ids = {0, 1, 2, 3, 4};
+    for (const char* name : BROADPHASE_NAMES) {
+        std::unique_ptr<IBroadphase> broadphase = CreateBroadphase(name);
+        broadphase->Update(boxes.data(), filters.data(), ids.data(), static_cast<int>(boxes.size()), 3200.0f, 1920.0f);
+        std::vector<std::pair<int, int>> pairs;
+        broadphase->FindCandidatePairs(pairs);
+        CHECK(std::find(pairs.begin(), pairs.end(), std::make_pair(0, 1)) != pairs.end());
+        CHECK(std::find(pairs.begin(), pairs.end(), std::make_pair(2, 3)) != pairs.end());
+    }
+}
+
+// The benchmark replay agrees with its brute force reference.
+static void TestBenchmarkFindsNoMismatch() {
+    MovingBoxes moving_boxes(500, 11, true);
+    BroadphaseRecording recording;
+    std::vector<Aabb> boxes;
+    std::vector<CollisionFilter> filters;
+    std::vector<int> ids;
+    for (int frame = 0; frame < 10; frame++) {
+        moving_boxes.Step();
+        moving_boxes.GetFrame(boxes, filters, ids);
+        recording.AddFrame(boxes.data(), filters.data(), ids.data(), static_cast<int>(boxes.size()), moving_boxes.world_width, moving_boxes.world_height);
+    }
+
+    const std::vector<BroadphaseBenchmarkResult> results = RunBroadphaseBenchmark(recording);
+    CHECK(results.size() == 1 + sizeof(BROADPHASE_NAMES) / sizeof(BROADPHASE_NAMES[0]));
+    CHECK(results[0].name == "brute_force");
+    CHECK(results[0].num_overlapping_pairs > 0);
+    for (const auto& result : results) {
+        CHECK(result.num_mismatched_frames == 0);
+        CHECK(result.num_overlapping_pairs == results[0].num_overlapping_pairs);
+    }
+}
+
+// The packed box kernel keeps the overlapping pairs, in order, whatever the batch size of the instruction set.
+static void TestPackedKernelMatchesOverlaps() {
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(0.0f, 200.0f), size(0.0f, 30.0f);
+    std::vector<Aabb> boxes;
+    PackedAabbs packed_boxes;
+    for (int i = 0; i < 100; i++) {
+        const float x = position(random), y = position(random);
+        boxes.push_back({x, y, x + size(random), y + size(random)});
+        packed_boxes.Add(boxes.back());
+    }
+
+    // Counts that are and are not a multiple of the batch sizes.
+    for (int count : {0, 1, 3, 4, 8, 13, 1000}) {
+        std::vector<std::pair<int, int>> pairs;
+        for (int i = 0; i < count; i++) {
+            pairs.emplace_back(random() % boxes.size(), random() % boxes.size());
+        }
+        std::vector<std::pair<int, int>> expected_pairs;
+        for (const auto& pair : pairs) {
+            if (Overlaps(boxes[pair.first], boxes[pair.second])) {
+                expected_pairs.push_back(pair);
+            }
+        }
+        std::vector<std::pair<int, int>> overlapping_pairs(pairs.size());
+        overlapping_pairs.resize(FindOverlappingPairs(packed_boxes, pairs.data(), pairs.size(), overlapping_pairs.data()));
+        CHECK(overlapping_pairs == expected_pairs);
+    }
+}
+
+int main() {
+    RUN_TEST(TestBroadphasesMatchBruteForce);
+    RUN_TEST(TestBroadphasesFindBoxesOutsideTheWorld);
+    RUN_TEST(TestBenchmarkFindsNoMismatch);
+    RUN_TEST(TestPackedKernelMatchesOverlaps);
+    return GetTestResult();
+}
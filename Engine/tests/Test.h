@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the standalone tests: a failed check is reported and counted, and the test keeps going.
+inline int num_failed_checks = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            num_failed_checks++; \
+        } \
+    } while (0)
+
+// Run a test function and report it.
+#define RUN_TEST(test) \
+    do { \
+        const int num_failed_before = num_failed_checks; \
+        test(); \
+        std::printf("%s %s\n", num_failed_checks == num_failed_before ? "passed" : "FAILED", #test); \
+    } while (0)
+
+// Exit code of the test program.
+inline int GetTestResult() {
+    return num_failed_checks == 0 ? 0 : 1;
+}
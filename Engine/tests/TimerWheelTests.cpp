@@ -0,0 +1,178 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/Timer/TimerWheel.h"
+#include "Test.h"
+
+// Timers scheduled out of order fire in the order of their expiry time.
+static void TestTimersFireInExpiryOrder() {
+    TimerWheel timer_wheel(1000);
+    const uint32_t delays[] = {50, 3, 700, 64, 1, 4095, 65, 200000, 4096, 63};
+    for (uint32_t delay : delays) {
+        timer_wheel.Schedule(delay, 0, delay);
+    }
+    CHECK(timer_wheel.GetNumScheduledTimers() == 10);
+
+    std::vector<uint64_t> fired_delays;
+    timer_wheel.Advance(1000 + 300000, [&](TimerHandle, uint64_t user_data) {
+        fired_delays.push_back(user_data);
+    });
+    const std::vector<uint64_t> expected_delays = {1, 3, 50, 63, 64, 65, 700, 4095, 4096, 200000};
+    CHECK(fired_delays == expected_delays);
+    CHECK(timer_wheel.GetNumScheduledTimers() == 0);
+}
+
+// Timers placed in the upper levels move down as the time gets closer, and fire on the first Advance() past their expiry.
+static void TestTimersCascadeDownTheLevels() {
+    const uint32_t start_time = 12345;
+    // One delay per level, on both sides of the level boundaries.
+    const uint32_t delays[] = {
+        TIMER_WHEEL_SLOTS - 1, TIMER_WHEEL_SLOTS, TIMER_WHEEL_SLOTS + 1,
+        TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS - 1, TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS, TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS + 7,
+        TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS + 3, 1000000
+    };
+    for (uint32_t step : {1u, 7u, 1000u}) {
+        TimerWheel timer_wheel(start_time);
+        for (uint32_t delay : delays) {
+            timer_wheel.Schedule(delay, 0, delay);
+        }
+
+        int num_fired = 0;
+        uint32_t time = start_time;
+        while (timer_wheel.GetNumScheduledTimers() > 0 && time - start_time <= 2000000) {
+            const uint32_t previous_time = time;
+            time += step;
+            timer_wheel.Advance(time, [&](TimerHandle, uint64_t delay) {
+                const uint32_t expiry_time = start_time + static_cast<uint32_t>(delay);
+                CHECK(expiry_time > previous_time && expiry_time <= time);
+                num_fired++;
+            });
+        }
+        CHECK(num_fired == 8);
+    }
+}
+
+// A repeating timer fires once per elapsed period, even when one Advance() covers several periods.
+static void TestRepeatingTimerFiresEveryPeriod() {
+    TimerWheel timer_wheel(0);
+    TimerHandle handle = timer_wheel.Schedule(10, 25, 0);
+
+    int num_fired = 0;
+    timer_wheel.Advance(9, [&](TimerHandle, uint64_t) { num_fired++; });
+    CHECK(num_fired == 0);
+    // Fires at 10, 35, 60 and 85.
+    timer_wheel.Advance(100, [&](TimerHandle fired_handle, uint64_t) {
+        CHECK(timer_wheel.IsScheduled(fired_handle));
+        num_fired++;
+    });
+    CHECK(num_fired == 4);
+    CHECK(timer_wheel.IsScheduled(handle));
+
+    CHECK(timer_wheel.Cancel(handle));
+    timer_wheel.Advance(1000, [&](TimerHandle, uint64_t) { num_fired++; });
+    CHECK(num_fired == 4);
+}
+
+// Cancelled timers never fire, and the handles of cancelled or fired timers are stale.
+static void TestCancel() {
+    TimerWheel timer_wheel(0);
+    TimerHandle cancelled = timer_wheel.Schedule(100, 0, 1);
+    TimerHandle fired = timer_wheel.Schedule(50, 0, 2);
+    TimerHandle cancelled_by_callback = timer_wheel.Schedule(50, 0, 3);
+    CHECK(timer_wheel.Cancel(cancelled));
+    CHECK(!timer_wheel.Cancel(cancelled));
+    CHECK(!timer_wheel.IsScheduled(cancelled));
+
+    // Both timers at 50 are due in the same Advance(), the first one called back cancels the other.
+    std::vector<uint64_t> fired_user_data;
+    timer_wheel.Advance(200, [&](TimerHandle handle, uint64_t user_data) {
+        fired_user_data.push_back(user_data);
+        timer_wheel.Cancel(handle.index == fired.index ? cancelled_by_callback : fired);
+    });
+    CHECK(fired_user_data.size() == 1);
+    CHECK(!timer_wheel.IsScheduled(fired));
+    CHECK(!timer_wheel.Cancel(fired));
+    CHECK(timer_wheel.GetNumScheduledTimers() == 0);
+
+    // The recycled timer gets a new handle, the old one stays stale.
+    TimerHandle reused = timer_wheel.Schedule(10, 0, 4);
+    CHECK(timer_wheel.IsScheduled(reused));
+    CHECK(!timer_wheel.IsScheduled(fired) && !timer_wheel.IsScheduled(cancelled));
+}
+
+// Random schedules, cancels and advances, checked against the expiry times kept on the side,
+// including around the wrap of the 32-bit time.
+static void TestRandomTimersAgainstReference() {
+    for (uint32_t start_time : {0u, 12345u, 0xFFFFF000u}) {
+        TimerWheel timer_wheel(start_time);
+        std::mt19937 random(start_time + 1);
+
+        struct ExpectedTimer
+        {
+            uint32_t expiry_time;
+            uint32_t period;
+            TimerHandle handle;
+            bool is_scheduled;
+        };
+        std::vector<ExpectedTimer> expected_timers;
+
+        uint32_t time = start_time;
+        for (int step = 0; step < 5000; step++) {
+            const int num_new_timers = random() % 4;
+            for (int i = 0; i < num_new_timers; i++) {
+                const int range = random() % 10;
+                const uint32_t delay = range < 6 ? random() % 100 : range < 9 ? random() % 20000 : random() % 40000000;
+                const uint32_t period = random() % 5 == 0 ? 1 + random() % 500 : 0;
+                const TimerHandle handle = timer_wheel.Schedule(delay, period, expected_timers.size());
+                // A delay of 0 fires on the next millisecond.
+                expected_timers.push_back({time + (delay > 0 ? delay : 1), period, handle, true});
+            }
+            if (random() % 20 == 0 && !expected_timers.empty()) {
+                ExpectedTimer& expected_timer = expected_timers[random() % expected_timers.size()];
+                CHECK(timer_wheel.Cancel(expected_timer.handle) == expected_timer.is_scheduled);
+                expected_timer.is_scheduled = false;
+            }
+
+            const uint32_t previous_time = time;
+            time += random() % 50 == 0 ? random() % 100000 : random() % 40;
+            timer_wheel.Advance(time, [&](TimerHandle handle, uint64_t user_data) {
+                ExpectedTimer& expected_timer = expected_timers[user_data];
+                CHECK(expected_timer.is_scheduled);
+                CHECK(static_cast<int32_t>(expected_timer.expiry_time - time) <= 0);
+                CHECK(static_cast<int32_t>(expected_timer.expiry_time - previous_time) > 0);
+                if (expected_timer.period > 0) {
+                    expected_timer.expiry_time += expected_timer.period;
+                    if (random() % 3 == 0) {
+                        timer_wheel.Cancel(handle);
+                        expected_timer.is_scheduled = false;
+                    }
+                } else {
+                    expected_timer.is_scheduled = false;
+                }
+            });
+
+            // Everything still scheduled is in the future.
+            for (const auto& expected_timer : expected_timers) {
+                if (expected_timer.is_scheduled) {
+                    CHECK(static_cast<int32_t>(expected_timer.expiry_time - time) > 0);
+                }
+            }
+        }
+
+        int num_scheduled_timers = 0;
+        for (const auto& expected_timer : expected_timers) {
+            num_scheduled_timers += expected_timer.is_scheduled;
+        }
+        CHECK(num_scheduled_timers == timer_wheel.GetNumScheduledTimers());
+    }
+}
+
+int main() {
+    RUN_TEST(TestTimersFireInExpiryOrder);
+    RUN_TEST(TestTimersCascadeDownTheLevels);
+    RUN_TEST(TestRepeatingTimerFiresEveryPeriod);
+    RUN_TEST(TestCancel);
+    RUN_TEST(TestRandomTimersAgainstReference);
+    return GetTestResult();
+}